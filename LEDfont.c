@@ -0,0 +1,413 @@
+/*****************************************************
+ *
+ *	LED matrix driver for Raspberry RP2040
+ *	(c) Peter Schulten, Mülheim, Germany
+ *	peter_(at)_pitschu.de
+ *
+ *  Unmodified reproduction and distribution of this entire
+ *  source code in any form is permitted provided the above
+ *  notice is preserved.
+ *  I make this source code available free of charge and therefore
+ *  offer neither support nor guarantee for its functionality.
+ *  Furthermore, I assume no liability for the consequences of
+ *  its use.
+ *  The source code may only be used and modified for private,
+ *  non-commercial purposes. Any further use requires my consent.
+ *
+ *	History
+ *	25.01.2022	pitschu		Start of work
+ */
+
+/////////////////////////////////////////////
+//      Bitmap fonts on the LEDmx canvas and overlay
+//      glyphs are converted once into horizontal spans of equal coverage,
+//      drawing a cached glyph is a few LEDmx_HLine() calls
+/////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "hub75.h"
+#include "LEDmx.h"
+#include "LEDfont.h"
+
+#define LEDFONT_LEVEL_FULL      15          // coverage of 1 bpp pixels and opaque 4 bpp pixels
+#define LEDFONT_REPLACEMENT     0xFFFD      // decoded for invalid UTF-8
+
+typedef struct ledfontSpan_s {
+    uint8_t         x, y;               // from the top left corner of the glyph bitmap
+    uint8_t         len;
+    uint8_t         level;              // coverage 1..15
+} ledfontSpan_t;
+
+typedef struct ledfontTarget_s {
+    rgb_t*          image;              // NULL = LEDmx canvas or overlay
+    int             width, height;
+    uint32_t        value;              // canvas value of the color for images
+    rgb_t           color;
+    bool            overlay;
+} ledfontTarget_t;
+
+typedef struct ledfontSlot_s {
+    const ledfont_t*      font;         // NULL = free
+    const ledfontGlyph_t* glyph;
+    uint32_t        code;
+    uint16_t        first, count;       // spans in ledfontSpans
+} ledfontSlot_t;
+
+#define LEDFONT_SPANS   (LEDFONT_CACHE_SIZE / sizeof(ledfontSpan_t))
+
+static ledfontSlot_t ledfontSlots[LEDFONT_CACHE_SLOTS];
+static ledfontSpan_t ledfontSpans[LEDFONT_SPANS];
+static int          ledfontSpansUsed = 0;
+
+
+
+/*
+ * Decode the next UTF-8 character and advance *text past it. Returns 0 at the end of the string and
+ * U+FFFD for a malformed sequence (one byte is skipped then), overlong forms and surrogates count as malformed.
+ */
+uint32_t LEDfont_NextChar(const char** text)
+{
+    const uint8_t* s = (const uint8_t*)*text;
+    uint32_t c = s[0], min;
+    int n;
+
+    if (c == 0)
+        return 0;
+    if (c < 0x80)
+    {
+        *text += 1;
+        return c;
+    }
+    if ((c & 0xE0) == 0xC0)
+    {
+        n = 1; c &= 0x1F; min = 0x80;
+    }
+    else if ((c & 0xF0) == 0xE0)
+    {
+        n = 2; c &= 0x0F; min = 0x800;
+    }
+    else if ((c & 0xF8) == 0xF0)
+    {
+        n = 3; c &= 0x07; min = 0x10000;
+    }
+    else
+    {
+        *text += 1;
+        return LEDFONT_REPLACEMENT;
+    }
+
+    for (int i = 1; i <= n; i++)
+    {
+        if ((s[i] & 0xC0) != 0x80)      // also stops at the terminating 0
+        {
+            *text += 1;
+            return LEDFONT_REPLACEMENT;
+        }
+        c = (c << 6) | (s[i] & 0x3F);
+    }
+    *text += 1 + n;
+    if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+        return LEDFONT_REPLACEMENT;
+    return c;
+}
+
+
+
+/*
+ * Binary search of a code point in the sorted glyph table
+ */
+static const ledfontGlyph_t* LEDfont_FindGlyph(const ledfont_t* font, uint32_t code)
+{
+    int lo = 0, hi = font->glyphCount - 1;
+
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) >> 1;
+        uint32_t c = font->glyphs[mid].code;
+
+        if (c == code)
+            return &font->glyphs[mid];
+        if (c < code)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return NULL;
+}
+
+
+
+/*
+ * Glyph of a code point, '?' for characters the font does not have
+ */
+static const ledfontGlyph_t* LEDfont_Glyph(const ledfont_t* font, uint32_t code)
+{
+    const ledfontGlyph_t* g = LEDfont_FindGlyph(font, code);
+
+    return (g != NULL) ? g : LEDfont_FindGlyph(font, '?');
+}
+
+
+
+/*
+ * Kerning of the pair left, right, 0 if the font has none
+ */
+static int LEDfont_Kerning(const ledfont_t* font, uint32_t left, uint32_t right)
+{
+    uint32_t key = (left << 16) | right;
+    int lo = 0, hi = font->kernCount - 1;
+
+    if (font->kernCount == 0 || left > 0xFFFF || right > 0xFFFF)
+        return 0;
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) >> 1;
+        uint32_t k = ((uint32_t)font->kerning[mid].left << 16) | font->kerning[mid].right;
+
+        if (k == key)
+            return font->kerning[mid].dx;
+        if (k < key)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return 0;
+}
+
+
+
+/*
+ * Coverage 0..15 of pixel x in a bitmap line
+ */
+static inline int LEDfont_Level(const ledfont_t* font, const uint8_t* line, int x)
+{
+    if (font->bpp == 1)
+        return (line[x >> 3] & (0x80 >> (x & 7))) ? LEDFONT_LEVEL_FULL : 0;
+    return (line[x >> 1] >> ((x & 1) * 4)) & 0x0F;
+}
+
+
+
+/*
+ * Draw one span of a glyph: full coverage as plain line, partial coverage blended on the canvas.
+ * The overlay has no blending, it takes the pixels of at least half coverage.
+ */
+static inline void LEDfont_DrawSpan(const ledfontTarget_t* t, int x, int y, int len, int level)
+{
+    if (t->image != NULL)
+    {
+        int l = max(x, 0), r = min(x + len, t->width);
+        rgb_t* p;
+
+        if (y < 0 || y >= t->height)
+            return;
+        for (p = &t->image[y * t->width + l]; l < r; l++, p++)
+            *p = (level == LEDFONT_LEVEL_FULL) ? t->value : hub75_alpha_blend(*p, t->value, hub75_alpha_256(level * 17));
+    }
+    else if (level == LEDFONT_LEVEL_FULL || (t->overlay && level >= 8))
+        LEDmx_HLine(x, x + len - 1, y, t->color, t->overlay);
+    else if (!t->overlay)
+        LEDmx_HLineAlpha(x, x + len - 1, y, t->color, level * 17);
+}
+
+
+
+/*
+ * Split a glyph bitmap into runs of equal coverage. With spans != NULL the runs are stored (up to max,
+ * returns -1 if they do not fit), without they are drawn at x, y right away. Returns the number of runs.
+ */
+static int LEDfont_Rasterise(const ledfont_t* font, const ledfontGlyph_t* g, ledfontSpan_t* spans, int max,
+                             const ledfontTarget_t* t, int x, int y)
+{
+    int lineBytes = (g->w * font->bpp + 7) >> 3;
+    const uint8_t* line = &font->bitmaps[g->offset];
+    int n = 0;
+
+    for (int gy = 0; gy < g->h; gy++, line += lineBytes)
+    {
+        int gx = 0;
+
+        while (gx < g->w)
+        {
+            int level = LEDfont_Level(font, line, gx);
+            int start = gx;
+
+            while (++gx < g->w && LEDfont_Level(font, line, gx) == level)
+                ;
+            if (level == 0)
+                continue;
+            if (spans == NULL)
+                LEDfont_DrawSpan(t, x + start, y + gy, gx - start, level);
+            else if (n >= max)
+                return -1;
+            else
+            {
+                spans[n].x = start;
+                spans[n].y = gy;
+                spans[n].len = gx - start;
+                spans[n].level = level;
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+
+
+void LEDfont_ClearCache(void)
+{
+    memset(ledfontSlots, 0, sizeof(ledfontSlots));
+    ledfontSpansUsed = 0;
+}
+
+
+
+/*
+ * Cache slot of a character, converts the glyph on a miss. The slots are direct mapped, the span pool
+ * is filled up and then emptied at once. NULL if the font has no glyph for it or it is too big for the pool.
+ */
+static const ledfontSlot_t* LEDfont_Cached(const ledfont_t* font, uint32_t code)
+{
+    ledfontSlot_t* slot = &ledfontSlots[(code ^ ((uintptr_t)font >> 2) * 7) & (LEDFONT_CACHE_SLOTS - 1)];
+    const ledfontGlyph_t* g;
+    int n;
+
+    if (slot->font == font && slot->code == code)
+        return slot;
+
+    if ((g = LEDfont_Glyph(font, code)) == NULL)
+        return NULL;
+    n = LEDfont_Rasterise(font, g, &ledfontSpans[ledfontSpansUsed], LEDFONT_SPANS - ledfontSpansUsed, NULL, 0, 0);
+    if (n < 0)
+    {
+        LEDfont_ClearCache();
+        n = LEDfont_Rasterise(font, g, ledfontSpans, LEDFONT_SPANS, NULL, 0, 0);
+    }
+    if (n < 0)
+        return NULL;
+
+    slot->font = font;
+    slot->code = code;
+    slot->glyph = g;
+    slot->first = ledfontSpansUsed;
+    slot->count = n;
+    ledfontSpansUsed += n;
+    return slot;
+}
+
+
+
+/*
+ * Text loop of LEDfont_DrawText() and LEDfont_RenderText(), glyphs outside of cl..cr, ct..cb are skipped
+ */
+static int LEDfont_Text(const ledfont_t* font, int x, int y, const char* text, const ledfontTarget_t* t,
+                        int cl, int ct, int cr, int cb)
+{
+    int px = x, py = y;
+    uint32_t code, prev = 0;
+
+    while ((code = LEDfont_NextChar(&text)) != 0)
+    {
+        const ledfontSlot_t* slot;
+        const ledfontGlyph_t* g;
+
+        if (code == '\n')
+        {
+            px = x;
+            py += font->height;
+            prev = 0;
+            continue;
+        }
+        px += LEDfont_Kerning(font, prev, code);
+        prev = code;
+
+        if (py > cb || py + font->height <= ct)     // line outside of the clip rectangle
+        {
+            if ((g = LEDfont_Glyph(font, code)) != NULL)
+                px += g->advance;
+            continue;
+        }
+        if ((slot = LEDfont_Cached(font, code)) != NULL)
+        {
+            int gx = px + slot->glyph->dx, gy = py + slot->glyph->dy;
+
+            g = slot->glyph;
+            if (gx <= cr && gx + g->w > cl && gy <= cb && gy + g->h > ct)
+            {
+                const ledfontSpan_t* s = &ledfontSpans[slot->first];
+
+                for (int i = 0; i < slot->count; i++, s++)
+                    LEDfont_DrawSpan(t, gx + s->x, gy + s->y, s->len, s->level);
+            }
+        }
+        else if ((g = LEDfont_Glyph(font, code)) != NULL)
+            LEDfont_Rasterise(font, g, NULL, 0, t, px + g->dx, py + g->dy);
+        else
+            continue;
+        px += g->advance;
+    }
+    return px;
+}
+
+
+
+/*
+ * Draw UTF-8 text with its line top at y, '\n' starts a new line at x. Glyphs outside the clip
+ * rectangle are only advanced over. 4 bpp fonts are blended on the canvas with the draw alpha.
+ * Returns the pen position after the last character.
+ */
+int LEDfont_DrawText(const ledfont_t* font, int16_t x, int16_t y, const char* text, rgb_t color, bool overlay)
+{
+    ledfontTarget_t t = { NULL, 0, 0, 0, color, overlay };
+    int16_t cl, ct, cr, cb;
+
+    LEDmx_GetClip(&cl, &cr, &ct, &cb);
+    return LEDfont_Text(font, x, y, text, &t, cl, ct, cr, cb);
+}
+
+
+
+/*
+ * Draw text into an image of width x height canvas pixels instead of the canvas, e.g. the band
+ * of LEDmx_Ticker() that is wider than the panel. 4 bpp fonts are blended onto the image.
+ */
+int LEDfont_RenderText(const ledfont_t* font, rgb_t* image, int width, int height, int16_t x, int16_t y,
+                       const char* text, rgb_t color)
+{
+    ledfontTarget_t t = { image, width, height, 0, color, false };
+
+    t.value = RGB(MAP_888_R_TO_PWM(color), MAP_888_G_TO_PWM(color), MAP_888_B_TO_PWM(color));
+    return LEDfont_Text(font, x, y, text, &t, 0, 0, width - 1, height - 1);
+}
+
+
+
+/*
+ * Width of the longest line of the text in pixels (sum of advances and kerning)
+ */
+int LEDfont_TextWidth(const ledfont_t* font, const char* text)
+{
+    int w = 0, width = 0;
+    uint32_t code, prev = 0;
+
+    while ((code = LEDfont_NextChar(&text)) != 0)
+    {
+        const ledfontGlyph_t* g;
+
+        if (code == '\n')
+        {
+            w = 0;
+            prev = 0;
+            continue;
+        }
+        w += LEDfont_Kerning(font, prev, code);
+        prev = code;
+        if ((g = LEDfont_Glyph(font, code)) != NULL)
+            w += g->advance;
+        width = max(width, w);
+    }
+    return width;
+}
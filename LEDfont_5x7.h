@@ -0,0 +1,238 @@
+// Generated by hub75font from led5x7.bdf: 104 glyphs, 1 bpp, height 8, 10 kerning pair(s). Do not edit.
+#ifndef LEDFONT_5X7__H_
+#define LEDFONT_5X7__H_
+
+#include "LEDfont.h"
+
+static const uint8_t ledfont_5x7_bitmaps[] = {
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x80,    // U+0021
+	0xa0, 0xa0,    // U+0022
+	0x50, 0x50, 0xf8, 0x50, 0xf8, 0x50, 0x50,    // U+0023
+	0x20, 0x78, 0xa0, 0x70, 0x28, 0xf0, 0x20,    // U+0024
+	0xc0, 0xc8, 0x10, 0x20, 0x40, 0x98, 0x18,    // U+0025
+	0x60, 0x90, 0xa0, 0x40, 0xa8, 0x90, 0x68,    // U+0026
+	0x80, 0x80,    // U+0027
+	0x20, 0x40, 0x80, 0x80, 0x80, 0x40, 0x20,    // U+0028
+	0x80, 0x40, 0x20, 0x20, 0x20, 0x40, 0x80,    // U+0029
+	0x20, 0xa8, 0x70, 0xa8, 0x20,    // U+002A
+	0x20, 0x20, 0xf8, 0x20, 0x20,    // U+002B
+	0x60, 0x40, 0x80,    // U+002C
+	0xf8,    // U+002D
+	0xc0, 0xc0,    // U+002E
+	0x08, 0x10, 0x20, 0x40, 0x80,    // U+002F
+	0x70, 0x88, 0x98, 0xa8, 0xc8, 0x88, 0x70,    // U+0030
+	0x40, 0xc0, 0x40, 0x40, 0x40, 0x40, 0xe0,    // U+0031
+	0x70, 0x88, 0x08, 0x10, 0x20, 0x40, 0xf8,    // U+0032
+	0xf8, 0x10, 0x20, 0x10, 0x08, 0x88, 0x70,    // U+0033
+	0x10, 0x30, 0x50, 0x90, 0xf8, 0x10, 0x10,    // U+0034
+	0xf8, 0x80, 0xf0, 0x08, 0x08, 0x88, 0x70,    // U+0035
+	0x30, 0x40, 0x80, 0xf0, 0x88, 0x88, 0x70,    // U+0036
+	0xf8, 0x08, 0x10, 0x20, 0x40, 0x40, 0x40,    // U+0037
+	0x70, 0x88, 0x88, 0x70, 0x88, 0x88, 0x70,    // U+0038
+	0x70, 0x88, 0x88, 0x78, 0x08, 0x10, 0x60,    // U+0039
+	0xc0, 0xc0, 0x00, 0xc0, 0xc0,    // U+003A
+	0xc0, 0xc0, 0x00, 0xc0, 0x40, 0x80,    // U+003B
+	0x10, 0x20, 0x40, 0x80, 0x40, 0x20, 0x10,    // U+003C
+	0xf8, 0x00, 0xf8,    // U+003D
+	0x80, 0x40, 0x20, 0x10, 0x20, 0x40, 0x80,    // U+003E
+	0x70, 0x88, 0x08, 0x10, 0x20, 0x00, 0x20,    // U+003F
+	0x70, 0x88, 0x08, 0x68, 0xa8, 0xa8, 0x70,    // U+0040
+	0x70, 0x88, 0x88, 0xf8, 0x88, 0x88, 0x88,    // U+0041
+	0xf0, 0x88, 0x88, 0xf0, 0x88, 0x88, 0xf0,    // U+0042
+	0x70, 0x88, 0x80, 0x80, 0x80, 0x88, 0x70,    // U+0043
+	0xe0, 0x90, 0x88, 0x88, 0x88, 0x90, 0xe0,    // U+0044
+	0xf8, 0x80, 0x80, 0xf0, 0x80, 0x80, 0xf8,    // U+0045
+	0xf8, 0x80, 0x80, 0xf0, 0x80, 0x80, 0x80,    // U+0046
+	0x70, 0x88, 0x80, 0xb8, 0x88, 0x88, 0x78,    // U+0047
+	0x88, 0x88, 0x88, 0xf8, 0x88, 0x88, 0x88,    // U+0048
+	0xe0, 0x40, 0x40, 0x40, 0x40, 0x40, 0xe0,    // U+0049
+	0x38, 0x10, 0x10, 0x10, 0x10, 0x90, 0x60,    // U+004A
+	0x88, 0x90, 0xa0, 0xc0, 0xa0, 0x90, 0x88,    // U+004B
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0xf8,    // U+004C
+	0x88, 0xd8, 0xa8, 0xa8, 0x88, 0x88, 0x88,    // U+004D
+	0x88, 0x88, 0xc8, 0xa8, 0x98, 0x88, 0x88,    // U+004E
+	0x70, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70,    // U+004F
+	0xf0, 0x88, 0x88, 0xf0, 0x80, 0x80, 0x80,    // U+0050
+	0x70, 0x88, 0x88, 0x88, 0xa8, 0x90, 0x68,    // U+0051
+	0xf0, 0x88, 0x88, 0xf0, 0xa0, 0x90, 0x88,    // U+0052
+	0x78, 0x80, 0x80, 0x70, 0x08, 0x08, 0xf0,    // U+0053
+	0xf8, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,    // U+0054
+	0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70,    // U+0055
+	0x88, 0x88, 0x88, 0x88, 0x88, 0x50, 0x20,    // U+0056
+	0x88, 0x88, 0x88, 0xa8, 0xa8, 0xa8, 0x50,    // U+0057
+	0x88, 0x88, 0x50, 0x20, 0x50, 0x88, 0x88,    // U+0058
+	0x88, 0x88, 0x50, 0x20, 0x20, 0x20, 0x20,    // U+0059
+	0xf8, 0x08, 0x10, 0x20, 0x40, 0x80, 0xf8,    // U+005A
+	0xe0, 0x80, 0x80, 0x80, 0x80, 0x80, 0xe0,    // U+005B
+	0x80, 0x40, 0x20, 0x10, 0x08,    // U+005C
+	0xe0, 0x20, 0x20, 0x20, 0x20, 0x20, 0xe0,    // U+005D
+	0x20, 0x50, 0x88,    // U+005E
+	0xf8,    // U+005F
+	0x80, 0x40,    // U+0060
+	0x70, 0x08, 0x78, 0x88, 0x78,    // U+0061
+	0x80, 0x80, 0xb0, 0xc8, 0x88, 0x88, 0xf0,    // U+0062
+	0x70, 0x80, 0x80, 0x88, 0x70,    // U+0063
+	0x08, 0x08, 0x68, 0x98, 0x88, 0x88, 0x78,    // U+0064
+	0x70, 0x88, 0xf8, 0x80, 0x70,    // U+0065
+	0x30, 0x48, 0x40, 0xe0, 0x40, 0x40, 0x40,    // U+0066
+	0x78, 0x88, 0x88, 0x78, 0x08, 0x70,    // U+0067
+	0x80, 0x80, 0xb0, 0xc8, 0x88, 0x88, 0x88,    // U+0068
+	0x40, 0x00, 0xc0, 0x40, 0x40, 0x40, 0xe0,    // U+0069
+	0x10, 0x00, 0x30, 0x10, 0x10, 0x10, 0x90, 0x60,    // U+006A
+	0x80, 0x80, 0x90, 0xa0, 0xc0, 0xa0, 0x90,    // U+006B
+	0xc0, 0x40, 0x40, 0x40, 0x40, 0x40, 0xe0,    // U+006C
+	0xd0, 0xa8, 0xa8, 0x88, 0x88,    // U+006D
+	0xb0, 0xc8, 0x88, 0x88, 0x88,    // U+006E
+	0x70, 0x88, 0x88, 0x88, 0x70,    // U+006F
+	0xf0, 0x88, 0x88, 0xf0, 0x80, 0x80,    // U+0070
+	0x78, 0x88, 0x88, 0x78, 0x08, 0x08,    // U+0071
+	0xb0, 0xc8, 0x80, 0x80, 0x80,    // U+0072
+	0x70, 0x80, 0x70, 0x08, 0xf0,    // U+0073
+	0x40, 0x40, 0xe0, 0x40, 0x40, 0x48, 0x30,    // U+0074
+	0x88, 0x88, 0x88, 0x98, 0x68,    // U+0075
+	0x88, 0x88, 0x88, 0x50, 0x20,    // U+0076
+	0x88, 0x88, 0xa8, 0xa8, 0x50,    // U+0077
+	0x88, 0x50, 0x20, 0x50, 0x88,    // U+0078
+	0x88, 0x88, 0x88, 0x78, 0x08, 0x70,    // U+0079
+	0xf8, 0x10, 0x20, 0x40, 0xf8,    // U+007A
+	0x20, 0x40, 0x40, 0x80, 0x40, 0x40, 0x20,    // U+007B
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,    // U+007C
+	0x80, 0x40, 0x40, 0x20, 0x40, 0x40, 0x80,    // U+007D
+	0x40, 0xa8, 0x10,    // U+007E
+	0x60, 0x90, 0x90, 0x60,    // U+00B0
+	0x88, 0x70, 0x88, 0x88, 0xf8, 0x88, 0x88,    // U+00C4
+	0x88, 0x70, 0x88, 0x88, 0x88, 0x88, 0x70,    // U+00D6
+	0x88, 0x00, 0x88, 0x88, 0x88, 0x88, 0x70,    // U+00DC
+	0x60, 0x90, 0x90, 0xa0, 0x90, 0x90, 0xb0, 0x80,    // U+00DF
+	0x50, 0x00, 0x70, 0x08, 0x78, 0x88, 0x78,    // U+00E4
+	0x50, 0x00, 0x70, 0x88, 0x88, 0x88, 0x70,    // U+00F6
+	0x50, 0x00, 0x88, 0x88, 0x88, 0x98, 0x68,    // U+00FC
+	0x38, 0x40, 0xf0, 0x40, 0xf0, 0x40, 0x38,    // U+20AC
+};
+
+static const ledfontGlyph_t ledfont_5x7_glyphs[] = {
+	{ 0x0020,     0,  0,  0,  0,  0,  3 },
+	{ 0x0021,     0,  1,  7,  0,  0,  2 },
+	{ 0x0022,     7,  3,  2,  0,  0,  4 },
+	{ 0x0023,     9,  5,  7,  0,  0,  6 },
+	{ 0x0024,    16,  5,  7,  0,  0,  6 },
+	{ 0x0025,    23,  5,  7,  0,  0,  6 },
+	{ 0x0026,    30,  5,  7,  0,  0,  6 },
+	{ 0x0027,    37,  1,  2,  0,  0,  2 },
+	{ 0x0028,    39,  3,  7,  0,  0,  4 },
+	{ 0x0029,    46,  3,  7,  0,  0,  4 },
+	{ 0x002a,    53,  5,  5,  0,  1,  6 },
+	{ 0x002b,    58,  5,  5,  0,  1,  6 },
+	{ 0x002c,    63,  3,  3,  0,  5,  4 },
+	{ 0x002d,    66,  5,  1,  0,  3,  6 },
+	{ 0x002e,    67,  2,  2,  0,  5,  3 },
+	{ 0x002f,    69,  5,  5,  0,  1,  6 },
+	{ 0x0030,    74,  5,  7,  0,  0,  6 },
+	{ 0x0031,    81,  3,  7,  0,  0,  4 },
+	{ 0x0032,    88,  5,  7,  0,  0,  6 },
+	{ 0x0033,    95,  5,  7,  0,  0,  6 },
+	{ 0x0034,   102,  5,  7,  0,  0,  6 },
+	{ 0x0035,   109,  5,  7,  0,  0,  6 },
+	{ 0x0036,   116,  5,  7,  0,  0,  6 },
+	{ 0x0037,   123,  5,  7,  0,  0,  6 },
+	{ 0x0038,   130,  5,  7,  0,  0,  6 },
+	{ 0x0039,   137,  5,  7,  0,  0,  6 },
+	{ 0x003a,   144,  2,  5,  0,  1,  3 },
+	{ 0x003b,   149,  2,  6,  0,  1,  3 },
+	{ 0x003c,   155,  4,  7,  0,  0,  5 },
+	{ 0x003d,   162,  5,  3,  0,  2,  6 },
+	{ 0x003e,   165,  4,  7,  0,  0,  5 },
+	{ 0x003f,   172,  5,  7,  0,  0,  6 },
+	{ 0x0040,   179,  5,  7,  0,  0,  6 },
+	{ 0x0041,   186,  5,  7,  0,  0,  6 },
+	{ 0x0042,   193,  5,  7,  0,  0,  6 },
+	{ 0x0043,   200,  5,  7,  0,  0,  6 },
+	{ 0x0044,   207,  5,  7,  0,  0,  6 },
+	{ 0x0045,   214,  5,  7,  0,  0,  6 },
+	{ 0x0046,   221,  5,  7,  0,  0,  6 },
+	{ 0x0047,   228,  5,  7,  0,  0,  6 },
+	{ 0x0048,   235,  5,  7,  0,  0,  6 },
+	{ 0x0049,   242,  3,  7,  0,  0,  4 },
+	{ 0x004a,   249,  5,  7,  0,  0,  6 },
+	{ 0x004b,   256,  5,  7,  0,  0,  6 },
+	{ 0x004c,   263,  5,  7,  0,  0,  6 },
+	{ 0x004d,   270,  5,  7,  0,  0,  6 },
+	{ 0x004e,   277,  5,  7,  0,  0,  6 },
+	{ 0x004f,   284,  5,  7,  0,  0,  6 },
+	{ 0x0050,   291,  5,  7,  0,  0,  6 },
+	{ 0x0051,   298,  5,  7,  0,  0,  6 },
+	{ 0x0052,   305,  5,  7,  0,  0,  6 },
+	{ 0x0053,   312,  5,  7,  0,  0,  6 },
+	{ 0x0054,   319,  5,  7,  0,  0,  6 },
+	{ 0x0055,   326,  5,  7,  0,  0,  6 },
+	{ 0x0056,   333,  5,  7,  0,  0,  6 },
+	{ 0x0057,   340,  5,  7,  0,  0,  6 },
+	{ 0x0058,   347,  5,  7,  0,  0,  6 },
+	{ 0x0059,   354,  5,  7,  0,  0,  6 },
+	{ 0x005a,   361,  5,  7,  0,  0,  6 },
+	{ 0x005b,   368,  3,  7,  0,  0,  4 },
+	{ 0x005c,   375,  5,  5,  0,  1,  6 },
+	{ 0x005d,   380,  3,  7,  0,  0,  4 },
+	{ 0x005e,   387,  5,  3,  0,  0,  6 },
+	{ 0x005f,   390,  5,  1,  0,  6,  6 },
+	{ 0x0060,   391,  2,  2,  0,  0,  3 },
+	{ 0x0061,   393,  5,  5,  0,  2,  6 },
+	{ 0x0062,   398,  5,  7,  0,  0,  6 },
+	{ 0x0063,   405,  5,  5,  0,  2,  6 },
+	{ 0x0064,   410,  5,  7,  0,  0,  6 },
+	{ 0x0065,   417,  5,  5,  0,  2,  6 },
+	{ 0x0066,   422,  5,  7,  0,  0,  6 },
+	{ 0x0067,   429,  5,  6,  0,  2,  6 },
+	{ 0x0068,   435,  5,  7,  0,  0,  6 },
+	{ 0x0069,   442,  3,  7,  0,  0,  4 },
+	{ 0x006a,   449,  4,  8,  0,  0,  5 },
+	{ 0x006b,   457,  4,  7,  0,  0,  5 },
+	{ 0x006c,   464,  3,  7,  0,  0,  4 },
+	{ 0x006d,   471,  5,  5,  0,  2,  6 },
+	{ 0x006e,   476,  5,  5,  0,  2,  6 },
+	{ 0x006f,   481,  5,  5,  0,  2,  6 },
+	{ 0x0070,   486,  5,  6,  0,  2,  6 },
+	{ 0x0071,   492,  5,  6,  0,  2,  6 },
+	{ 0x0072,   498,  5,  5,  0,  2,  6 },
+	{ 0x0073,   503,  5,  5,  0,  2,  6 },
+	{ 0x0074,   508,  5,  7,  0,  0,  6 },
+	{ 0x0075,   515,  5,  5,  0,  2,  6 },
+	{ 0x0076,   520,  5,  5,  0,  2,  6 },
+	{ 0x0077,   525,  5,  5,  0,  2,  6 },
+	{ 0x0078,   530,  5,  5,  0,  2,  6 },
+	{ 0x0079,   535,  5,  6,  0,  2,  6 },
+	{ 0x007a,   541,  5,  5,  0,  2,  6 },
+	{ 0x007b,   546,  3,  7,  0,  0,  4 },
+	{ 0x007c,   553,  1,  7,  0,  0,  2 },
+	{ 0x007d,   560,  3,  7,  0,  0,  4 },
+	{ 0x007e,   567,  5,  3,  0,  2,  6 },
+	{ 0x00b0,   570,  4,  4,  0,  0,  5 },
+	{ 0x00c4,   574,  5,  7,  0,  0,  6 },
+	{ 0x00d6,   581,  5,  7,  0,  0,  6 },
+	{ 0x00dc,   588,  5,  7,  0,  0,  6 },
+	{ 0x00df,   595,  4,  8,  0,  0,  5 },
+	{ 0x00e4,   603,  5,  7,  0,  0,  6 },
+	{ 0x00f6,   610,  5,  7,  0,  0,  6 },
+	{ 0x00fc,   617,  5,  7,  0,  0,  6 },
+	{ 0x20ac,   624,  5,  7,  0,  0,  6 },
+};
+
+static const ledfontKern_t ledfont_5x7_kerning[] = {
+	{ 0x0041, 0x0054, -1 },
+	{ 0x0041, 0x0056, -1 },
+	{ 0x0046, 0x002e, -1 },
+	{ 0x004c, 0x0054, -1 },
+	{ 0x004c, 0x0056, -1 },
+	{ 0x0050, 0x002e, -1 },
+	{ 0x0054, 0x002e, -1 },
+	{ 0x0054, 0x0041, -1 },
+	{ 0x0056, 0x0041, -1 },
+	{ 0x0059, 0x002e, -1 },
+};
+
+static const ledfont_t ledfont_5x7 = {
+	1, 8, 7, 104, 10,
+	ledfont_5x7_glyphs, ledfont_5x7_kerning, ledfont_5x7_bitmaps
+};
+
+#endif
@@ -30,6 +30,8 @@
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 #include "hub75.h"
 #include "LEDmx.h"
 
@@ -39,21 +41,127 @@ uint32_t* display_back_buf = &display_buffers[0];
 
 uint32_t* ledmxActiveImage = &display_buffers[0];
 
-uint8_t  overlayBuffer[DISPLAY_FRAMEBUFFER_SIZE];
+uint8_t  overlayBuffer[LEDMX_OVERLAY_SIZE];
 
 static QueueHandle_t flushBlock;
 
 static alpha_t 		alphaChannel;
+static uint32_t     ledmxDrawAlpha = 256;       // weight 0..256 of the drawing color, see LEDmx_SetDrawAlpha()
+
+static bool         ledmxCanvasHidden = false;  // a cached screen or animation is shown, canvas is not flushed
+static volatile bool ledmxCanvasDirty = true;   // canvas or overlay changed since they were encoded, see LEDmx_Invalidate()
+
+#ifdef HUB75_BCM
+static bool         ledmxLowLatency = false;    // flush the canvas with hub75_update_stream(), see LEDmx_SetLowLatency()
+static bool         ledmxTickerOn = false;      // LEDmx_Ticker() runs: the band is refreshed, the canvas encoded on changes
+static hub75_row_fn ledmxGenerator = NULL;     // procedural content replaces the canvas when set
+static void*        ledmxGeneratorCtx = NULL;
+static hub75_row_fn ledmxUserGenerator = NULL; // set by LEDmx_SetGenerator(), shown while layers and tilemap are off
+static void*        ledmxUserGeneratorCtx = NULL;
+static bool         ledmxLayersOn = false;
+static uint8_t*     ledmxIndexImage = NULL;     // palette indexed canvas (first quarter of display_buffers) when set
+static rgb_t        ledmxPalette[256];
+
+typedef struct ledmxLayer_s {
+    uint8_t         format;         // LEDMX_LAYER_xxx, LEDMX_LAYER_OFF = not set up
+    bool            visible;
+    int8_t          z;              // layers with higher z are drawn on top
+    int16_t         x, y;           // screen position of the top left pixel
+    int16_t         w, h;
+    void*           pixels;         // w * h pixels, nibble layers: even pixel in the low nibble
+    uint16_t*       occupancy;      // one word per layer line, bit n: span n (LEDMX_SPAN pixels) has content
+    const rgb_t*    colors;         // indexed and nibble layers: color of each index, index 0 is transparent
+    const uint8_t*  blend;          // HUB75_BLEND_xxx of each index
+} ledmxLayer_t;
+
+static ledmxLayer_t ledmxLayers[LEDMX_LAYERS];
+static uint8_t      ledmxLayerOrder[LEDMX_LAYERS];  // layer indices sorted by z, bottom first
+static rgb_t        ledmxBackground = BLACK;
+static const uint8_t ledmxReplace[256];             // blend table of layers without one
+
+typedef struct ledmxTilemap_s {
+    bool            on;
+    const uint32_t* tiles;          // 8 words per tile, one per tile line, pixel x in nibble x
+    int             tileCount;
+    uint16_t*       map;            // mapW * mapH entries: tile | LEDMX_TILE_PAL(n) | flips
+    int16_t         mapW, mapH;     // tiles, powers of 2
+    int16_t         sx, sy;         // scroll registers: world pixel at the top left screen corner
+    const rgb_t*    colors;         // 16 palettes of 16 colors
+} ledmxTilemap_t;
+
+static ledmxTilemap_t ledmxTilemap;
+
+static void LEDmx_LayerLine(int y, rgb_t* line, void* ctx);
+static void LEDmx_TileLine(int y, rgb_t* line, void* ctx);
+#endif
+
+static int          ledmxDmaChan = -1;          // fill / blit data channel, claimed on first use
+static int          ledmxDmaBlocksChan = -1;    // feeds the row blocks to the data channel
+static uint32_t     ledmxDmaBlocks[DISPLAY_HEIGHT + 1][2];  // {read address, write address} per row, {0, 0} ends
+static uint32_t     ledmxDmaFill;               // fill value, read without increment
+static volatile bool ledmxDmaBusy = false;
+static LEDmx_dma_fn ledmxDmaDone = NULL;
+static void*        ledmxDmaCtx = NULL;
+
+typedef struct ledmxRect_s {
+    int16_t         l, t, r, b;     // inclusive, empty if l > r
+} ledmxRect_t;
+
+static ledmxRect_t  ledmxClip = { 0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1 };
+static ledmxRect_t  ledmxClipStack[LEDMX_CLIP_DEPTH];
+static int          ledmxClipDepth = 0;
+
+
+#ifdef HUB75_BCM
+/*
+ * Encode the canvas and the overlay
+ */
+static void LEDmx_FlushCanvas(void)
+{
+    if (ledmxLowLatency)
+        hub75_update_stream(ledmxActiveImage, overlayBuffer);
+    else
+        hub75_update(ledmxActiveImage, overlayBuffer);
+}
+
+#endif
+
 
 
 static void LEDmx_task(void* pvParameters)
 {
     while (true)
     {
+        int delay = 3;
+
         LEDmx_getFlushSemaphore();
+#ifdef HUB75_BCM
+        if (ledmxGenerator != NULL || ledmxIndexImage != NULL)
+            ledmxCanvasDirty = true;           // the frame on screen is not the canvas
+        if (ledmxGenerator != NULL && !ledmxCanvasHidden)
+            hub75_update_generator(ledmxGenerator, ledmxGeneratorCtx);
+        else if (ledmxIndexImage != NULL && !ledmxCanvasHidden)
+            hub75_update_indexed(ledmxIndexImage, ledmxPalette, overlayBuffer);
+        else if (ledmxTickerOn && !ledmxCanvasHidden)
+        {
+            if (!ledmxCanvasDirty)
+            {
+                hub75_ticker_refresh();         // only the band moves: a few words per line instead of a frame
+                delay = 1;
+            }
+            else
+            {
+                ledmxCanvasDirty = false;       // cleared before encoding, a change while encoding shows next time
+                LEDmx_FlushCanvas();
+            }
+        }
+        else if (!ledmxCanvasHidden)
+            LEDmx_FlushCanvas();
+#else
         hub75_update(ledmxActiveImage, overlayBuffer);
+#endif
         LEDmx_putFlushSemaphore();
-        vTaskDelay(3);
+        vTaskDelay(delay);
 
     }
 }
@@ -65,6 +173,9 @@ void LEDmx_start()
     xSemaphoreGive(flushBlock);
 
     hub75_config(8);
+#ifdef LEDMX_OVERLAY_NIBBLE
+    hub75_set_overlayformat(HUB75_OVERLAY_NIBBLE);
+#endif
 
     BaseType_t xReturned;
     TaskHandle_t xHandle = NULL;
@@ -80,227 +191,1664 @@ void LEDmx_start()
 
 
 
-void LEDmx_getFlushSemaphore(void)
+#ifdef HUB75_BCM
+/*
+ * Flush the canvas band by band behind the display beam (hub75_update_stream()) instead of as a whole.
+ * Lowers the latency of interactive content, but each band may busy-wait for the beam with the flush
+ * semaphore taken, so it is off by default.
+ */
+void LEDmx_SetLowLatency(bool on)
 {
-    xSemaphoreTake(flushBlock, 100);
+    ledmxLowLatency = on;
 }
 
 
 
-void LEDmx_putFlushSemaphore(void)
+/*
+ * Select the generator of the task: layers, tilemap or the one of LEDmx_SetGenerator(), in that order
+ */
+static void LEDmx_SelectGenerator(void)
 {
-    xSemaphoreGive(flushBlock);
+    LEDmx_getFlushSemaphore();
+    if (ledmxLayersOn)
+    {
+        ledmxGeneratorCtx = NULL;
+        ledmxGenerator = LEDmx_LayerLine;
+    }
+    else if (ledmxTilemap.on)
+    {
+        ledmxGeneratorCtx = NULL;
+        ledmxGenerator = LEDmx_TileLine;
+    }
+    else
+    {
+        ledmxGeneratorCtx = ledmxUserGeneratorCtx;
+        ledmxGenerator = ledmxUserGenerator;
+    }
+    LEDmx_putFlushSemaphore();
 }
 
 
-void LEDmx_SetPixel(int x, int y, rgb_t color)
+
+/*
+ * Flush procedural content from a row generator instead of the canvas, NULL = canvas.
+ * Layers and tilemap take precedence while they are in use, the generator is kept for afterwards.
+ */
+void LEDmx_SetGenerator(hub75_row_fn rowFn, void* ctx)
 {
-    ledmxActiveImage[y * DISPLAY_WIDTH + x] = color;
+    ledmxUserGeneratorCtx = ctx;
+    ledmxUserGenerator = rowFn;
+    LEDmx_SelectGenerator();
 }
 
 
-void LEDmx_SetPixelRGB(int x, int y, uint8_t R, uint8_t G, uint8_t B)
+
+/*
+ * Encode the current canvas and overlay into the frame cache of the driver
+ */
+int LEDmx_StoreScreen(uint32_t key)
 {
-    LEDmx_SetPixel(x, y, RGB(R, G, B));
+    LEDmx_getFlushSemaphore();
+    int rc = hub75_cache_store(key, ledmxActiveImage, overlayBuffer);
+    LEDmx_putFlushSemaphore();
+    return rc;
 }
 
 
 
-void LEDmx_SetMasterBrightness(int brt)
+/*
+ * Show a cached screen. The canvas is not flushed until LEDmx_ShowCanvas() is called
+ */
+int LEDmx_ShowScreen(uint32_t key)
 {
-    hub75_set_masterbrightness(brt);
+    LEDmx_getFlushSemaphore();
+    int rc = hub75_cache_show(key);
+    if (rc == 0)
+        ledmxCanvasHidden = true;
+    LEDmx_putFlushSemaphore();
+    return rc;
 }
 
 
 
+/*
+ * Play a pre-encoded animation. The canvas is not flushed until LEDmx_ShowCanvas() is called
+ */
+int LEDmx_PlayAnimation(const hub75_anim_t* anim, int flags)
+{
+    LEDmx_getFlushSemaphore();
+    int rc = hub75_anim_play(anim, flags);
+    if (rc == 0)
+        ledmxCanvasHidden = true;
+    LEDmx_putFlushSemaphore();
+    return rc;
+}
+
 
-void LEDmx_DrawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2, rgb_t color, bool overlay)
+
+/*
+ * Scroll a band of canvas pixels (e.g. text drawn by LEDfont_RenderText()) over the image lines from top on,
+ * see hub75_ticker_setup(). speed is in 16.16 columns per BCM cycle; the canvas below the band is not shown.
+ * While the canvas and the overlay stay unchanged the task only calls hub75_ticker_refresh(), so the band
+ * scrolls smoothly at almost no CPU; driver settings changed through hub75_set_xxx() directly instead of
+ * the LEDmx functions show with the next canvas change then.
+ */
+int LEDmx_Ticker(uint32_t* strip, const rgb_t* image, int width, int height, int top, int32_t speed)
+{
+    LEDmx_getFlushSemaphore();
+    int rc = hub75_ticker_setup(strip, image, width, height, top);
+    if (rc == 0)
+    {
+        hub75_ticker_scroll(0, speed);
+        ledmxTickerOn = true;
+        ledmxCanvasDirty = true;
+    }
+    LEDmx_putFlushSemaphore();
+    return rc;
+}
+
+
+
+void LEDmx_TickerStop(void)
 {
-    signed int x, y, addx, addy, dx, dy;
-    signed long P;
-    int i;
+    LEDmx_getFlushSemaphore();
+    hub75_ticker_stop();
+    ledmxTickerOn = false;
+    LEDmx_putFlushSemaphore();
+}
 
-    dx = abs((signed int)(x2 - x1));
-    dy = abs((signed int)(y2 - y1));
-    x = x1;
-    y = y1;
 
-    addx = addy = 1;
-    if (x1 > x2)
-        addx = -1;
-    if (y1 > y2)
-        addy = -1;
 
-    if (dx >= dy)
+void LEDmx_ShowCanvas(void)
+{
+    LEDmx_getFlushSemaphore();
+    hub75_anim_stop();          // a staged animation must not stream into the frame the task encodes
+    ledmxCanvasHidden = false;
+    ledmxCanvasDirty = true;
+    LEDmx_putFlushSemaphore();
+}
+
+
+
+/*
+ * Switch the canvas to 8 bit palette indices. The indexed canvas uses the first quarter of
+ * display_buffers, it is cleared to index 0 when the mode is switched on.
+ */
+void LEDmx_SetIndexedMode(bool on)
+{
+    LEDmx_getFlushSemaphore();
+    if (on && ledmxIndexImage == NULL)
+    {
+        ledmxIndexImage = (uint8_t*)display_buffers;
+        memset(ledmxIndexImage, 0, DISPLAY_FRAMEBUFFER_SIZE);
+    }
+    else if (!on)
+        ledmxIndexImage = NULL;
+    LEDmx_putFlushSemaphore();
+}
+
+
+
+void LEDmx_SetIndexPixel(int x, int y, uint8_t index)
+{
+    if (ledmxIndexImage != NULL && !LEDmx_IsClipped(x, y))
+        ledmxIndexImage[y * DISPLAY_WIDTH + x] = index;
+}
+
+
+
+void LEDmx_ClearIndexed(uint8_t index)
+{
+    if (ledmxIndexImage != NULL)
+        memset(ledmxIndexImage, index, DISPLAY_FRAMEBUFFER_SIZE);
+}
+
+
+
+void LEDmx_SetPalette(int first, int count, const rgb_t* colors)
+{
+    if (first < 0 || count < 0 || first + count > 256)
+        return;
+    LEDmx_getFlushSemaphore();
+    memcpy(&ledmxPalette[first], colors, count * sizeof(rgb_t));
+    LEDmx_putFlushSemaphore();
+}
+
+
+
+static void LEDmx_ReversePalette(int from, int to)         // entries from .. to - 1
+{
+    for (to--; from < to; from++, to--)
+    {
+        rgb_t c = ledmxPalette[from];
+        ledmxPalette[from] = ledmxPalette[to];
+        ledmxPalette[to] = c;
+    }
+}
+
+
+
+/*
+ * Color cycling: rotate the palette entries first .. first + count - 1 by 'step' entries.
+ * Takes effect with the next flush, the pixel data is not touched.
+ * Rotates in place by three reversals, no copy of the range on the stack.
+ */
+void LEDmx_RotatePalette(int first, int count, int step)
+{
+    if (first < 0 || count <= 0 || first + count > 256)
+        return;
+    step %= count;
+    if (step < 0)
+        step += count;
+
+    LEDmx_getFlushSemaphore();
+    LEDmx_ReversePalette(first, first + count);
+    LEDmx_ReversePalette(first, first + step);
+    LEDmx_ReversePalette(first + step, first + count);
+    LEDmx_putFlushSemaphore();
+}
+
+
+
+/*
+ * Compositor: the layers replace canvas and overlay while LEDmx_UseLayers() is on.
+ * The encoder pulls the screen line by line from LEDmx_LayerLine(); each layer only draws
+ * the runs of spans marked in its occupancy bitmap.
+ */
+static void LEDmx_LayerSort(void)
+{
+    for (int i = 0; i < LEDMX_LAYERS; i++)
+        ledmxLayerOrder[i] = i;
+    for (int i = 1; i < LEDMX_LAYERS; i++)      // insertion sort, stable for equal z
+    {
+        uint8_t n = ledmxLayerOrder[i];
+        int j = i;
+
+        for (; j > 0 && ledmxLayers[ledmxLayerOrder[j - 1]].z > ledmxLayers[n].z; j--)
+            ledmxLayerOrder[j] = ledmxLayerOrder[j - 1];
+        ledmxLayerOrder[j] = n;
+    }
+}
+
+
+
+/*
+ * Draw n pixels of layer line 'row' starting at layer column x0 onto dst
+ */
+static void LEDmx_LayerSpan(rgb_t* dst, const ledmxLayer_t* l, int row, int x0, int n)
+{
+    const uint8_t* blend = l->blend ? l->blend : ledmxReplace;
+
+    if (l->format == LEDMX_LAYER_RGB)
+    {
+        memcpy(dst, (const rgb_t*)l->pixels + row * l->w + x0, n * sizeof(rgb_t));
+    }
+    else if (l->format == LEDMX_LAYER_INDEXED)
     {
-        P = 2L * dy - dx;
-        for (i = 0; i <= dx; ++i)
+        hub75_overlay_line(dst, (const uint8_t*)l->pixels + row * l->w + x0, n, HUB75_OVERLAY_BYTE, l->colors, blend);
+    }
+    else
+    {
+        const uint8_t* p = (const uint8_t*)l->pixels + row * (l->w / 2);
+
+        if (x0 & 1)     // odd start: first pixel on its own, the rest starts on a byte
         {
-            if (overlay)
-                LEDmx_SetOverlayPixel(x, y, color);
-            else
-                LEDmx_DrawPixel(x, y, color);
-            if (P < 0)
-            {
-                P += 2 * dy;
-                x += addx;
-            }
-            else
-            {
-                P += 2 * dy - 2 * dx;
-                x += addx;
-                y += addy;
-            }
+            int i = hub75_overlay_index(p, x0, HUB75_OVERLAY_NIBBLE);
+
+            if (i != 0)
+                *dst = hub75_blend(*dst, l->colors[i], blend[i]);
+            dst++;
+            x0++;
+            n--;
         }
+        if (n & 1)
+        {
+            int i = hub75_overlay_index(p, x0 + n - 1, HUB75_OVERLAY_NIBBLE);
+
+            if (i != 0)
+                dst[n - 1] = hub75_blend(dst[n - 1], l->colors[i], blend[i]);
+            n--;
+        }
+        if (n > 0)
+            hub75_overlay_line(dst, p + x0 / 2, n, HUB75_OVERLAY_NIBBLE, l->colors, blend);
     }
+}
+
+
+
+static void LEDmx_LayerLine(int y, rgb_t* line, void* ctx)
+{
+    if (ledmxTilemap.on)                // the tilemap is the background of the layers
+        LEDmx_TileLine(y, line, NULL);
     else
+        for (int x = 0; x < DISPLAY_WIDTH; x++)
+            line[x] = ledmxBackground;
+
+    for (int k = 0; k < LEDMX_LAYERS; k++)
     {
-        P = 2L * dx - dy;
-        for (i = 0; i <= dy; ++i)
+        const ledmxLayer_t* l = &ledmxLayers[ledmxLayerOrder[k]];
+        int row = y - l->y;
+
+        if (l->format == LEDMX_LAYER_OFF || !l->visible || row < 0 || row >= l->h)
+            continue;
+
+        uint32_t occ = l->occupancy[row];
+
+        while (occ != 0)        // runs of occupied spans
         {
-            if (overlay)
-                LEDmx_SetOverlayPixel(x, y, color);
-            else
-                LEDmx_DrawPixel(x, y, color);
-            if (P < 0)
-            {
-                P += 2 * dx;
-                y += addy;
-            }
-            else
-            {
-                P += 2 * dx - 2 * dy;
-                x += addx;
-                y += addy;
-            }
+            int s = __builtin_ctz(occ);
+            int e = s + __builtin_ctz(~(occ >> s));
+            int x0 = s * LEDMX_SPAN, x1 = e * LEDMX_SPAN;
+
+            occ &= ~((1u << e) - 1);
+            if (x1 > l->w)
+                x1 = l->w;
+            if (l->x + x0 < 0)                          // clip to the screen
+                x0 = -l->x;
+            if (l->x + x1 > DISPLAY_WIDTH)
+                x1 = DISPLAY_WIDTH - l->x;
+            if (x0 < x1)
+                LEDmx_LayerSpan(&line[l->x + x0], l, row, x0, x1 - x0);
         }
     }
 }
 
 
 
-void LEDmx_setAlphaDisabled(void)
+/*
+ * Set up layer 'layer' with a pixel buffer of w * h pixels (rgb_t, uint8_t or 4 bits per pixel) and
+ * an occupancy bitmap of h words, both owned by the caller. The layer starts empty and hidden.
+ */
+int LEDmx_LayerSetup(int layer, int format, int w, int h, void* pixels, uint16_t* occupancy)
 {
-    alphaChannel.active = 0;
+    if (layer < 0 || layer >= LEDMX_LAYERS || format < LEDMX_LAYER_OFF || format > LEDMX_LAYER_NIBBLE)
+        return -1;
+    if (format != LEDMX_LAYER_OFF && (pixels == NULL || occupancy == NULL || w <= 0 || h <= 0 ||
+        w > 16 * LEDMX_SPAN || (format == LEDMX_LAYER_NIBBLE && (w & 1))))
+        return -1;
+
+    LEDmx_getFlushSemaphore();
+    ledmxLayer_t* l = &ledmxLayers[layer];
+    l->format = format;
+    l->visible = false;
+    l->w = w;
+    l->h = h;
+    l->pixels = pixels;
+    l->occupancy = occupancy;
+    l->colors = ledmxPalette;
+    l->blend = NULL;
+    if (format != LEDMX_LAYER_OFF)
+        memset(occupancy, 0, h * sizeof(uint16_t));
+    LEDmx_LayerSort();
+    LEDmx_putFlushSemaphore();
+    return 0;
 }
 
 
 
-void LEDmx_setAlpha(rgb_t color)
+void LEDmx_LayerSetColors(int layer, const rgb_t* colors, const uint8_t* blend)
 {
-    alphaChannel.r = MAP_888_R_TO_PWM(color);
-    alphaChannel.g = MAP_888_G_TO_PWM(color);
-    alphaChannel.b = MAP_888_B_TO_PWM(color);
-
-    alphaChannel.active = 1;
+    if (layer < 0 || layer >= LEDMX_LAYERS || colors == NULL)
+        return;
+    LEDmx_getFlushSemaphore();
+    ledmxLayers[layer].colors = colors;
+    ledmxLayers[layer].blend = blend;
+    LEDmx_putFlushSemaphore();
 }
 
 
 
-void LEDmx_setAlphaRGB(uint8_t r, uint8_t g, uint8_t b)
+void LEDmx_LayerMove(int layer, int x, int y)
 {
-    alphaChannel.r = (r & 0xff) >> (8 - bitPlanes);
-    alphaChannel.g = (g & 0xff) >> (8 - bitPlanes);
-    alphaChannel.b = (b & 0xff) >> (8 - bitPlanes);
-
-    alphaChannel.active = 1;
+    if (layer < 0 || layer >= LEDMX_LAYERS)
+        return;
+    LEDmx_getFlushSemaphore();
+    ledmxLayers[layer].x = x;
+    ledmxLayers[layer].y = y;
+    LEDmx_putFlushSemaphore();
 }
 
 
 
-void LEDmx_DrawPixel(int16_t x, int16_t y, rgb_t color)
+void LEDmx_LayerShow(int layer, bool visible)
 {
-    uint8_t r, g, b;
+    if (layer >= 0 && layer < LEDMX_LAYERS)
+        ledmxLayers[layer].visible = visible;
+}
 
-    if (LEDmx_IsClipped(x, y))
+
+
+void LEDmx_LayerSetZ(int layer, int z)
+{
+    if (layer < 0 || layer >= LEDMX_LAYERS)
         return;
+    LEDmx_getFlushSemaphore();
+    ledmxLayers[layer].z = z;
+    LEDmx_LayerSort();
+    LEDmx_putFlushSemaphore();
+}
 
-    r = MAP_888_R_TO_PWM(color);
-    g = MAP_888_G_TO_PWM(color);
-    b = MAP_888_B_TO_PWM(color);
 
-    if (alphaChannel.active)
+
+/*
+ * Set a pixel of a layer (color for RGB layers, index otherwise) and mark its span as occupied.
+ * x, y are layer coordinates.
+ */
+void LEDmx_LayerSetPixel(int layer, int x, int y, uint32_t value)
+{
+    if (layer < 0 || layer >= LEDMX_LAYERS)
+        return;
+    ledmxLayer_t* l = &ledmxLayers[layer];
+    if (l->format == LEDMX_LAYER_OFF || x < 0 || x >= l->w || y < 0 || y >= l->h)
+        return;
+
+    if (l->format == LEDMX_LAYER_RGB)
+        ((rgb_t*)l->pixels)[y * l->w + x] = value;
+    else if (l->format == LEDMX_LAYER_INDEXED)
+        ((uint8_t*)l->pixels)[y * l->w + x] = value;
+    else
     {
-        if (alphaChannel.r == r && alphaChannel.g == g && alphaChannel.b == b)
-            return;
+        uint8_t* p = &((uint8_t*)l->pixels)[(y * l->w + x) >> 1];
+        int shift = (x & 1) * 4;
+
+        *p = (*p & ~(0x0F << shift)) | ((value & 0x0F) << shift);
     }
+    l->occupancy[y] |= 1u << (x / LEDMX_SPAN);
+}
 
-    LEDmx_SetPixelRGB(x, y, r, g, b);
-    return;
+
+
+/*
+ * Mark a rectangle of a layer as occupied after writing its pixel buffer directly
+ */
+void LEDmx_LayerMark(int layer, int x, int y, int w, int h)
+{
+    if (layer < 0 || layer >= LEDMX_LAYERS || ledmxLayers[layer].format == LEDMX_LAYER_OFF || w <= 0 || x + w <= 0)
+        return;
+    ledmxLayer_t* l = &ledmxLayers[layer];
+    int s = max(x, 0) / LEDMX_SPAN, e = (min(x + w, l->w) - 1) / LEDMX_SPAN;
+    uint16_t bits = (e >= s) ? ((2u << e) - 1) & ~((1u << s) - 1) : 0;
+
+    for (int r = max(y, 0); r < min(y + h, l->h); r++)
+        l->occupancy[r] |= bits;
 }
 
 
 
-void LEDmx_Rect(int16_t left, int16_t top, int16_t right, int16_t bottom, rgb_t color, bool overlay)
+/*
+ * Empty a layer: clears the occupancy bitmap, the pixel buffer is only cleared for indexed layers
+ * (index 0 = transparent) because RGB layers are opaque wherever a span is marked
+ */
+void LEDmx_LayerClear(int layer)
+{
+    if (layer < 0 || layer >= LEDMX_LAYERS || ledmxLayers[layer].format == LEDMX_LAYER_OFF)
+        return;
+    ledmxLayer_t* l = &ledmxLayers[layer];
+
+    memset(l->occupancy, 0, l->h * sizeof(uint16_t));
+    if (l->format == LEDMX_LAYER_INDEXED)
+        memset(l->pixels, 0, l->w * l->h);
+    else if (l->format == LEDMX_LAYER_NIBBLE)
+        memset(l->pixels, 0, l->w * l->h / 2);
+}
+
+
+
+/*
+ * Switch between the layers and the canvas with overlay. bg is the color below all layers.
+ */
+void LEDmx_UseLayers(bool on, rgb_t bg)
 {
-    register unsigned int x, y;
+    ledmxBackground = bg;
+    LEDmx_getFlushSemaphore();
+    LEDmx_LayerSort();
+    LEDmx_putFlushSemaphore();
+    ledmxLayersOn = on;
+    LEDmx_SelectGenerator();
+}
+
 
-    for (y = top; y <= bottom; y++)
+
+/*
+ * Row generator of the tilemap: one tile line lookup per 8 pixels, the 4 bit indices of a tile line
+ * are one word. Scroll positions wrap around the map.
+ */
+static void LEDmx_TileLine(int y, rgb_t* line, void* ctx)
+{
+    const ledmxTilemap_t* t = &ledmxTilemap;
+    int wy = (y + t->sy) & (t->mapH * LEDMX_TILE - 1);
+    int wx = t->sx & (t->mapW * LEDMX_TILE - 1);
+    const uint16_t* row = &t->map[(wy / LEDMX_TILE) * t->mapW];
+    int ty = wy % LEDMX_TILE;
+    int x = 0;
+
+    while (x < DISPLAY_WIDTH)
     {
-        for (x = left; x <= right; x++)
+        uint16_t e = row[wx / LEDMX_TILE];
+        int tx = wx % LEDMX_TILE;
+        int n = LEDMX_TILE - tx;
+        const rgb_t* pal = &t->colors[((e >> 10) & 0x0F) * 16];
+        uint32_t bits = t->tiles[(e & LEDMX_TILE_INDEX) * LEDMX_TILE + ((e & LEDMX_TILE_FLIPY) ? LEDMX_TILE - 1 - ty : ty)];
+
+        if (e & LEDMX_TILE_FLIPX)       // reverse the 8 nibbles
         {
-            if (overlay)
-                LEDmx_SetOverlayPixel(x, y, color);
-            else
-                LEDmx_DrawPixel(x, y, color);
+            bits = __builtin_bswap32(bits);
+            bits = ((bits >> 4) & 0x0F0F0F0F) | ((bits & 0x0F0F0F0F) << 4);
+        }
+        bits >>= 4 * tx;
+        if (n > DISPLAY_WIDTH - x)
+            n = DISPLAY_WIDTH - x;
+        wx = (wx + n) & (t->mapW * LEDMX_TILE - 1);
+        while (n-- > 0)
+        {
+            line[x++] = pal[bits & 0x0F];
+            bits >>= 4;
         }
     }
-    return;
 }
 
 
 
-void LEDmx_ClearScreen(rgb_t color)
+/*
+ * Set up the tilemap background: 'tiles' holds 'tileCount' 8x8 tiles of 4 bit indices, 'map' the
+ * mapW * mapH tile entries of the world (both powers of 2), both owned by the caller. 'colors' are
+ * 16 palettes of 16 colors, NULL = the palette of the indexed mode. Scroll registers are reset.
+ */
+int LEDmx_TilemapSetup(const uint32_t* tiles, int tileCount, uint16_t* map, int mapW, int mapH, const rgb_t* colors)
 {
-    for (int i = 0; i < DISPLAY_FRAMEBUFFER_SIZE; i++)
-        ledmxActiveImage[i] = (uint32_t)color;
+    if (tiles == NULL || map == NULL || tileCount <= 0 || tileCount > LEDMX_TILE_INDEX + 1 ||
+        mapW <= 0 || mapH <= 0 || (mapW & (mapW - 1)) || (mapH & (mapH - 1)) ||
+        mapW * LEDMX_TILE > 0x8000 || mapH * LEDMX_TILE > 0x8000)
+        return -1;
+
+    LEDmx_getFlushSemaphore();
+    ledmxTilemap.tiles = tiles;
+    ledmxTilemap.tileCount = tileCount;
+    ledmxTilemap.map = map;
+    ledmxTilemap.mapW = mapW;
+    ledmxTilemap.mapH = mapH;
+    ledmxTilemap.sx = ledmxTilemap.sy = 0;
+    ledmxTilemap.colors = (colors != NULL) ? colors : ledmxPalette;
+    LEDmx_putFlushSemaphore();
+    return 0;
 }
 
 
 
+/*
+ * Scroll registers: world pixel shown at the top left screen corner, taken over with the next flush
+ */
+void LEDmx_TilemapScroll(int x, int y)
+{
+    LEDmx_getFlushSemaphore();
+    ledmxTilemap.sx = x & (ledmxTilemap.mapW * LEDMX_TILE - 1);
+    ledmxTilemap.sy = y & (ledmxTilemap.mapH * LEDMX_TILE - 1);
+    LEDmx_putFlushSemaphore();
+}
 
-void LEDmx_BlankScreen(void)
+
+
+/*
+ * Set map entry tx, ty (wraps around the map): tile number | LEDMX_TILE_PAL(n) | LEDMX_TILE_FLIPX / _FLIPY
+ */
+void LEDmx_TilemapSet(int tx, int ty, uint16_t entry)
 {
-    LEDmx_ClearScreen(BLACK);
-    // needs no flush
+    if (ledmxTilemap.map == NULL || (entry & LEDMX_TILE_INDEX) >= ledmxTilemap.tileCount)
+        return;
+    ledmxTilemap.map[(ty & (ledmxTilemap.mapH - 1)) * ledmxTilemap.mapW + (tx & (ledmxTilemap.mapW - 1))] = entry;
 }
 
 
 
+/*
+ * Show the tilemap instead of the canvas, or as the background of the layers while they are in use
+ */
+void LEDmx_UseTilemap(bool on)
+{
+    if (on && ledmxTilemap.map == NULL)
+        return;
+    ledmxTilemap.on = on;
+    LEDmx_SelectGenerator();
+}
+#endif
+
+
 
-void LEDmx_SetClip(int16_t l, int16_t r, int16_t t, int16_t b)
+void LEDmx_getFlushSemaphore(void)
 {
-    //glcdSetWindow(l, t, r, b);
+    xSemaphoreTake(flushBlock, 100);
 }
 
 
 
-uint8_t LEDmx_IsClipped(int16_t x, int16_t y)
+void LEDmx_putFlushSemaphore(void)
 {
-    if ((x < 0) || (x >= DISPLAY_WIDTH) || (y < 0) || (y >= DISPLAY_HEIGHT))
-        return 1;
+    xSemaphoreGive(flushBlock);
+}
 
-    return 0;
+
+void LEDmx_SetPixel(int x, int y, rgb_t color)
+{
+    ledmxActiveImage[y * DISPLAY_WIDTH + x] = color;
+    ledmxCanvasDirty = true;
 }
 
 
-void LEDmx_ClearOverlay (void)
+void LEDmx_SetPixelRGB(int x, int y, uint8_t R, uint8_t G, uint8_t B)
 {
-    memset (overlayBuffer, 0, sizeof(overlayBuffer));
+    LEDmx_SetPixel(x, y, RGB(R, G, B));
 }
 
 
-void LEDmx_SetOverlayPixel(int x, int y, int color)
+
+/*
+ * Mark canvas and overlay as changed after writing them directly (display_buffers, overlayBuffer,
+ * LEDmx_FillSpan32() into the canvas). The drawing functions mark them themselves; while a ticker runs
+ * the task encodes the canvas only when it is marked, otherwise it just moves the ticker band.
+ */
+void LEDmx_Invalidate(void)
 {
-    if (!LEDmx_IsClipped(x,y))
-        overlayBuffer [(y * DISPLAY_WIDTH) + x] = color;
+    ledmxCanvasDirty = true;
 }
 
 
-void LEDmx_SetOverlayColor(int index, rgb_t color)
+
+void LEDmx_SetMasterBrightness(int brt)
 {
-    hub75_set_overlaycolor(index, color);
+    hub75_set_masterbrightness(brt);
+    ledmxCanvasDirty = true;       // encode the new OE flags even if the canvas is unchanged
+}
+
+
+
+
+void LEDmx_setAlphaDisabled(void)
+{
+    alphaChannel.active = 0;
+}
+
+
+
+void LEDmx_setAlpha(rgb_t color)
+{
+    alphaChannel.r = MAP_888_R_TO_PWM(color);
+    alphaChannel.g = MAP_888_G_TO_PWM(color);
+    alphaChannel.b = MAP_888_B_TO_PWM(color);
+
+    alphaChannel.active = 1;
+}
+
+
+
+void LEDmx_setAlphaRGB(uint8_t r, uint8_t g, uint8_t b)
+{
+    alphaChannel.r = (r & 0xff) >> MAP_888_PWM_SHIFT;
+    alphaChannel.g = (g & 0xff) >> MAP_888_PWM_SHIFT;
+    alphaChannel.b = (b & 0xff) >> MAP_888_PWM_SHIFT;
+
+    alphaChannel.active = 1;
+}
+
+
+
+/*
+ * Constant alpha of the canvas primitives (pixels, lines, rects): 255 draws opaque, lower values
+ * blend the drawing color over the canvas. The overlay and the DMA fill are not blended.
+ */
+void LEDmx_SetDrawAlpha(uint8_t alpha)
+{
+    ledmxDrawAlpha = hub75_alpha_256(alpha);
+}
+
+
+
+/*
+ * Store a canvas value with the draw alpha
+ */
+static inline void LEDmx_PutValue(uint32_t* p, uint32_t value)
+{
+    *p = (ledmxDrawAlpha == 256) ? value : hub75_alpha_blend(*p, value, ledmxDrawAlpha);
+}
+
+
+
+void LEDmx_DrawPixel(int16_t x, int16_t y, rgb_t color)
+{
+    uint8_t r, g, b;
+
+    if (LEDmx_IsClipped(x, y))
+        return;
+
+    r = MAP_888_R_TO_PWM(color);
+    g = MAP_888_G_TO_PWM(color);
+    b = MAP_888_B_TO_PWM(color);
+
+    if (alphaChannel.active)
+    {
+        if (alphaChannel.r == r && alphaChannel.g == g && alphaChannel.b == b)
+            return;
+    }
+
+    LEDmx_PutValue(&ledmxActiveImage[y * DISPLAY_WIDTH + x], RGB(r, g, b));
+    ledmxCanvasDirty = true;
+    return;
+}
+
+
+
+/*
+ * Fill count words with value, 8 word stores per loop
+ */
+void LEDmx_FillSpan32(uint32_t* dst, uint32_t value, int count)
+{
+    while (count >= 8)
+    {
+        dst[0] = value; dst[1] = value; dst[2] = value; dst[3] = value;
+        dst[4] = value; dst[5] = value; dst[6] = value; dst[7] = value;
+        dst += 8;
+        count -= 8;
+    }
+    while (count-- > 0)
+        *dst++ = value;
+}
+
+
+
+/*
+ * Fill count words with value and the draw alpha. The weighted color is the same for all
+ * pixels, so each pixel takes one multiply for R and B and one for G.
+ */
+static void LEDmx_PaintSpan(uint32_t* dst, uint32_t value, int count)
+{
+    uint32_t na = 256 - ledmxDrawAlpha;
+    uint32_t rb = (value & 0xFF00FF) * ledmxDrawAlpha;
+    uint32_t g = (value & 0x00FF00) * ledmxDrawAlpha;
+
+    if (na == 0)
+    {
+        LEDmx_FillSpan32(dst, value, count);
+        return;
+    }
+    while (count-- > 0)
+    {
+        uint32_t d = *dst;
+
+        *dst++ = (((rb + (d & 0xFF00FF) * na) >> 8) & 0xFF00FF) | (((g + (d & 0x00FF00) * na) >> 8) & 0x00FF00);
+    }
+}
+
+
+
+/*
+ * Intersect the rectangle l..r, t..b (inclusive, l <= r, t <= b) with the clip rectangle, false if nothing is left
+ */
+static bool LEDmx_ClipRect(int* l, int* t, int* r, int* b)
+{
+    *l = max(*l, ledmxClip.l);
+    *t = max(*t, ledmxClip.t);
+    *r = min(*r, ledmxClip.r);
+    *b = min(*b, ledmxClip.b);
+    return *l <= *r && *t <= *b;
+}
+
+
+
+/*
+ * Clip the span x1..x2 (inclusive, any order) of line y, false if nothing is left
+ */
+static bool LEDmx_ClipSpan(int* x1, int* x2, int y)
+{
+    int t = y, b = y;
+
+    if (*x1 > *x2)
+    {
+        int tmp = *x1;
+        *x1 = *x2;
+        *x2 = tmp;
+    }
+    return LEDmx_ClipRect(x1, &t, x2, &b);
+}
+
+
+
+/*
+ * Canvas value of a drawing color as stored by LEDmx_DrawPixel(), false if the alpha color hides it
+ */
+static bool LEDmx_PixelValue(rgb_t color, uint32_t* value)
+{
+    uint8_t r = MAP_888_R_TO_PWM(color);
+    uint8_t g = MAP_888_G_TO_PWM(color);
+    uint8_t b = MAP_888_B_TO_PWM(color);
+
+    if (alphaChannel.active && alphaChannel.r == r && alphaChannel.g == g && alphaChannel.b == b)
+        return false;
+    *value = RGB(r, g, b);
+    return true;
+}
+
+
+
+/*
+ * Store an overlay pixel, x and y are already clipped
+ */
+static inline void LEDmx_OverlayPut(int x, int y, int color)
+{
+#ifdef LEDMX_OVERLAY_NIBBLE
+    uint8_t* p = &overlayBuffer[(y * DISPLAY_WIDTH + x) >> 1];
+    int shift = (x & 1) * 4;
+
+    *p = (*p & ~(0x0F << shift)) | ((color & 0x0F) << shift);
+#else
+    overlayBuffer[y * DISPLAY_WIDTH + x] = color;
+#endif
+}
+
+
+
+/*
+ * Fill the overlay pixels x1..x2 (clipped, x1 <= x2) of line y
+ */
+static void LEDmx_OverlaySpan(int x1, int x2, int y, int color)
+{
+#ifdef LEDMX_OVERLAY_NIBBLE
+    if (x1 & 1)
+        LEDmx_OverlayPut(x1++, y, color);
+    if (!(x2 & 1))
+        LEDmx_OverlayPut(x2--, y, color);
+    if (x1 < x2)
+        memset(&overlayBuffer[(y * DISPLAY_WIDTH + x1) >> 1], (color & 0x0F) * 0x11, (x2 - x1 + 1) >> 1);
+#else
+    memset(&overlayBuffer[y * DISPLAY_WIDTH + x1], color, x2 - x1 + 1);
+#endif
+}
+
+
+
+/*
+ * Horizontal line from x1 to x2, clipped once, same pixel values as LEDmx_DrawPixel() / LEDmx_SetOverlayPixel()
+ */
+void LEDmx_HLine(int16_t x1, int16_t x2, int16_t y, rgb_t color, bool overlay)
+{
+    int l = x1, r = x2;
+    uint32_t value;
+
+    if (!LEDmx_ClipSpan(&l, &r, y))
+        return;
+    if (overlay)
+        LEDmx_OverlaySpan(l, r, y, color);
+    else if (LEDmx_PixelValue(color, &value))
+        LEDmx_PaintSpan(&ledmxActiveImage[y * DISPLAY_WIDTH + l], value, r - l + 1);
+    ledmxCanvasDirty = true;
+}
+
+
+
+/*
+ * Canvas line from x1 to x2 with an extra coverage 0..255 on top of the draw alpha (anti-aliased text)
+ */
+void LEDmx_HLineAlpha(int16_t x1, int16_t x2, int16_t y, rgb_t color, uint8_t alpha)
+{
+    uint32_t drawAlpha = ledmxDrawAlpha;
+
+    ledmxDrawAlpha = (drawAlpha * hub75_alpha_256(alpha)) >> 8;
+    if (ledmxDrawAlpha != 0)
+        LEDmx_HLine(x1, x2, y, color, false);
+    ledmxDrawAlpha = drawAlpha;
+}
+
+
+
+void LEDmx_VLine(int16_t x, int16_t y1, int16_t y2, rgb_t color, bool overlay)
+{
+    int l = x, r = x, t = min(y1, y2), b = max(y1, y2);
+    uint32_t value;
+
+    if (!LEDmx_ClipRect(&l, &t, &r, &b))
+        return;
+    if (overlay)
+    {
+        for (int y = t; y <= b; y++)
+            LEDmx_OverlayPut(x, y, color);
+    }
+    else if (LEDmx_PixelValue(color, &value))
+    {
+        uint32_t* p = &ledmxActiveImage[t * DISPLAY_WIDTH + x];
+
+        for (int y = t; y <= b; y++, p += DISPLAY_WIDTH)
+            LEDmx_PutValue(p, value);
+    }
+    ledmxCanvasDirty = true;
+}
+
+
+
+void LEDmx_Rect(int16_t left, int16_t top, int16_t right, int16_t bottom, rgb_t color, bool overlay)
+{
+    int l = left, t = top, r = right, b = bottom;
+    uint32_t value;
+
+    if (left > right || top > bottom || !LEDmx_ClipRect(&l, &t, &r, &b))
+        return;
+
+    if (overlay)
+    {
+        for (int y = t; y <= b; y++)
+            LEDmx_OverlaySpan(l, r, y, color);
+    }
+    else if (LEDmx_PixelValue(color, &value))
+    {
+        for (int y = t; y <= b; y++)
+            LEDmx_PaintSpan(&ledmxActiveImage[y * DISPLAY_WIDTH + l], value, r - l + 1);
+    }
+    ledmxCanvasDirty = true;
+}
+
+
+
+/*
+ * Cohen-Sutherland outcode of x, y against the clip rectangle
+ */
+static int LEDmx_OutCode(int x, int y)
+{
+    return (x < ledmxClip.l) | (x > ledmxClip.r) << 1 | (y < ledmxClip.t) << 2 | (y > ledmxClip.b) << 3;
+}
+
+
+
+/*
+ * Steps first..last (of 0..dm) of a Bresenham line inside the clip rectangle. Step i is at major coordinate
+ * m0 + am * i and minor coordinate n0 + an * k, k = (2 * dn * i + dm) / (2 * dm), both ranges are solved
+ * for i so the clipped line has exactly the pixels of the unclipped one. False if no step is inside.
+ */
+static bool LEDmx_ClipSteps(int m0, int am, int dm, int mlo, int mhi, int n0, int an, int dn, int nlo, int nhi,
+                            int* first, int* last)
+{
+    int lo = max(am > 0 ? mlo - m0 : m0 - mhi, 0);
+    int hi = min(am > 0 ? mhi - m0 : m0 - mlo, dm);
+    int klo = an > 0 ? nlo - n0 : n0 - nhi;
+    int khi = an > 0 ? nhi - n0 : n0 - nlo;
+
+    if (khi < 0 || klo > dn)
+        return false;
+    if (klo > 0)
+        lo = max(lo, (int)((2 * (int64_t)dm * klo - dm + 2 * dn - 1) / (2 * dn)));
+    if (khi < dn)
+        hi = min(hi, (int)((2 * (int64_t)dm * (khi + 1) - dm - 1) / (2 * dn)));
+    *first = lo;
+    *last = hi;
+    return lo <= hi;
+}
+
+
+
+/*
+ * Bresenham line, clipped up front: Cohen-Sutherland outcodes reject or accept it as a whole,
+ * a crossing line is cut to the steps inside the clip rectangle. No bounds test per pixel.
+ */
+void LEDmx_DrawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2, rgb_t color, bool overlay)
+{
+    int dx = abs(x2 - x1), dy = abs(y2 - y1);
+    int addx = (x1 > x2) ? -1 : 1, addy = (y1 > y2) ? -1 : 1;
+    int mx, my, nx, ny, dm, dn;         // step of the major and the minor axis, deltas
+    int first = 0, last, code1, code2, k, x, y;
+    uint32_t value = 0;
+    long P;
+
+    if (y1 == y2)
+    {
+        LEDmx_HLine(x1, x2, y1, color, overlay);
+        return;
+    }
+    if (x1 == x2)
+    {
+        LEDmx_VLine(x1, y1, y2, color, overlay);
+        return;
+    }
+
+    code1 = LEDmx_OutCode(x1, y1);
+    code2 = LEDmx_OutCode(x2, y2);
+    if ((code1 & code2) || (!overlay && !LEDmx_PixelValue(color, &value)))
+        return;
+
+    if (dx >= dy)
+    {
+        mx = addx; my = 0; nx = 0; ny = addy; dm = dx; dn = dy;
+        last = dx;
+        if ((code1 | code2) && !LEDmx_ClipSteps(x1, addx, dx, ledmxClip.l, ledmxClip.r,
+                                                y1, addy, dy, ledmxClip.t, ledmxClip.b, &first, &last))
+            return;
+    }
+    else
+    {
+        mx = 0; my = addy; nx = addx; ny = 0; dm = dy; dn = dx;
+        last = dy;
+        if ((code1 | code2) && !LEDmx_ClipSteps(y1, addy, dy, ledmxClip.t, ledmxClip.b,
+                                                x1, addx, dx, ledmxClip.l, ledmxClip.r, &first, &last))
+            return;
+    }
+
+    k = (int)((2 * (int64_t)dn * first + dm) / (2 * dm));
+    x = x1 + mx * first + nx * k;
+    y = y1 + my * first + ny * k;
+    P = (long)(2 * (int64_t)dn * (first + 1) - dm - 2 * (int64_t)dm * k);
+
+    for (int i = first; i <= last; i++)
+    {
+        if (overlay)
+            LEDmx_OverlayPut(x, y, color);
+        else
+            LEDmx_PutValue(&ledmxActiveImage[y * DISPLAY_WIDTH + x], value);
+        if (P >= 0)
+        {
+            P -= 2 * dm;
+            x += nx;
+            y += ny;
+        }
+        P += 2 * dn;
+        x += mx;
+        y += my;
+    }
+    ledmxCanvasDirty = true;
+}
+
+
+
+void LEDmx_ClearScreen(rgb_t color)
+{
+    LEDmx_FillSpan32(ledmxActiveImage, (uint32_t)color, DISPLAY_FRAMEBUFFER_SIZE);
+    ledmxCanvasDirty = true;
+}
+
+
+
+/*
+ * Fetch the source pixels sx .. sx + n - 1 of a bitmap line: colors of the RGB formats
+ * (RGB565 expanded to RGB888), indices of the indexed formats
+ */
+static void LEDmx_BmpFetch(uint32_t* dst, const ledmxBitmap_t* bmp, const uint8_t* line, int sx, int n)
+{
+    switch (bmp->format)
+    {
+    case LEDMX_BMP_RGB888:
+        memcpy(dst, &((const uint32_t*)line)[sx], n * sizeof(uint32_t));
+        break;
+    case LEDMX_BMP_RGB565:
+    {
+        const uint16_t* sp = &((const uint16_t*)line)[sx];
+
+        for (int i = 0; i < n; i++)
+            dst[i] = MAP_565_to_888(sp[i]);
+        break;
+    }
+    case LEDMX_BMP_INDEX8:
+    {
+        const uint8_t* sp = &line[sx];
+
+        while (n-- > 0)
+            *dst++ = *sp++;
+        break;
+    }
+    case LEDMX_BMP_INDEX4:
+        for (; n > 0; n--, sx++)
+            *dst++ = (line[sx >> 1] >> ((sx & 1) * 4)) & 0x0F;
+        break;
+    case LEDMX_BMP_INDEX1:
+        for (; n > 0; n--, sx++)
+            *dst++ = (line[sx >> 3] >> (7 - (sx & 7))) & 1;
+        break;
+    }
+}
+
+
+
+/*
+ * Draw a bitmap with its top left pixel at x, y, clipped. flags (LEDMX_BLIT_xxx) select color key
+ * transparency, horizontal / vertical flip and the overlay as target. On the canvas the indexed
+ * formats are colored by bmp->palette; into the overlay only indexed bitmaps are drawn, their
+ * index is the overlay color. Each visible line is fetched in one pass and stored in a second one,
+ * opaque unflipped lines of the native format are copied as a block.
+ */
+void LEDmx_Blit(int16_t x, int16_t y, const ledmxBitmap_t* bmp, int flags)
+{
+    uint32_t line[DISPLAY_WIDTH];
+    int l = x, t = y, r = x + bmp->w - 1, b = y + bmp->h - 1;
+    bool overlay = (flags & LEDMX_BLIT_OVERLAY) != 0;
+    bool key = (flags & LEDMX_BLIT_KEY) != 0;
+    bool flipX = (flags & LEDMX_BLIT_FLIPX) != 0;
+    bool indexed = bmp->format >= LEDMX_BMP_INDEX1;
+    int shift = MAP_888_PWM_SHIFT;
+    uint32_t mask = (0xFF >> shift) * 0x010101;
+
+    if (bmp->w <= 0 || bmp->h <= 0 || (overlay && !indexed) || (!overlay && indexed && bmp->palette == NULL) ||
+        !LEDmx_ClipRect(&l, &t, &r, &b))
+        return;
+
+    int n = r - l + 1;
+    int sx = flipX ? x + bmp->w - 1 - r : l - x;          // first visible source pixel, fetched forwards
+    bool block = !key && !flipX && shift == 0 && ((overlay && bmp->format == LEDMX_BMP_INDEX8) ||
+                                                  (!overlay && bmp->format == LEDMX_BMP_RGB888));
+#ifdef LEDMX_OVERLAY_NIBBLE
+    block = block && !overlay;
+#endif
+
+    for (int row = t; row <= b; row++)
+    {
+        int sy = (flags & LEDMX_BLIT_FLIPY) ? y + bmp->h - 1 - row : row - y;
+        const uint8_t* src = (const uint8_t*)bmp->pixels + sy * bmp->stride;
+
+        if (block)
+        {
+            if (overlay)
+                memcpy(&overlayBuffer[row * DISPLAY_WIDTH + l], &src[sx], n);
+            else
+                memcpy(&ledmxActiveImage[row * DISPLAY_WIDTH + l], &((const uint32_t*)src)[sx], n * sizeof(uint32_t));
+            continue;
+        }
+
+        LEDmx_BmpFetch(line, bmp, src, sx, n);
+        uint32_t* dst = &ledmxActiveImage[row * DISPLAY_WIDTH + l];
+        int step = flipX ? -1 : 1;
+        uint32_t* sp = flipX ? &line[n - 1] : line;
+
+        for (int i = 0; i < n; i++, sp += step)
+        {
+            uint32_t c = *sp;
+
+            if (key && c == bmp->key)
+                continue;
+            if (overlay)
+                LEDmx_OverlayPut(l + i, row, c);
+            else
+            {
+                if (indexed)
+                    c = bmp->palette[c];
+                dst[i] = (c >> shift) & mask;
+            }
+        }
+    }
+    ledmxCanvasDirty = true;
+}
+
+
+
+/*
+ * Raw pixel sx, sy of a bitmap: color of the RGB formats, index of the indexed formats
+ */
+static inline uint32_t LEDmx_BmpRaw(const ledmxBitmap_t* bmp, int sx, int sy)
+{
+    const uint8_t* line = (const uint8_t*)bmp->pixels + sy * bmp->stride;
+
+    switch (bmp->format)
+    {
+    case LEDMX_BMP_RGB888:
+        return ((const uint32_t*)line)[sx];
+    case LEDMX_BMP_RGB565:
+        return MAP_565_to_888(((const uint16_t*)line)[sx]);
+    case LEDMX_BMP_INDEX8:
+        return line[sx];
+    case LEDMX_BMP_INDEX4:
+        return (line[sx >> 1] >> ((sx & 1) * 4)) & 0x0F;
+    default:
+        return (line[sx >> 3] >> (7 - (sx & 7))) & 1;
+    }
+}
+
+
+
+static inline uint32_t LEDmx_BmpColor(const ledmxBitmap_t* bmp, int sx, int sy)
+{
+    uint32_t c = LEDmx_BmpRaw(bmp, sx, sy);
+
+    return (bmp->format >= LEDMX_BMP_INDEX1) ? bmp->palette[c] : c;
+}
+
+
+
+// sin() of 0 .. 90 degrees in 64 steps, 1.15 fixed point
+static const uint16_t ledmxSine[65] = {
+    0, 804, 1608, 2411, 3212, 4011, 4808, 5602, 6393, 7180, 7962, 8740, 9512,
+    10279, 11039, 11793, 12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531, 18205, 18868,
+    19520, 20160, 20788, 21403, 22006, 22595, 23170, 23732, 24279, 24812, 25330, 25833, 26320,
+    26791, 27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957, 30274, 30572, 30853, 31114,
+    31357, 31581, 31786, 31972, 32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758, 32768
+};
+
+
+
+/*
+ * Sine of 'angle' (65536 = full turn) in 16.16 fixed point, table interpolated linearly
+ */
+int32_t LEDmx_Sin(uint16_t angle)
+{
+    int p = angle & 0x3FFF;
+    int32_t v;
+
+    if (angle & 0x4000)
+        p = 0x4000 - p;             // 2nd and 4th quarter mirrored
+    v = ledmxSine[p >> 8];
+    if (p & 0xFF)
+        v += ((ledmxSine[(p >> 8) + 1] - v) * (p & 0xFF)) >> 8;
+    return (angle & 0x8000) ? -2 * v : 2 * v;
+}
+
+
+
+static int32_t LEDmx_Saturate32(int64_t v)
+{
+    return (v > INT32_MAX) ? INT32_MAX : ((v < INT32_MIN) ? INT32_MIN : (int32_t)v);
+}
+
+
+
+/*
+ * Matrix of LEDmx_BlitAffine() showing the source pixel sx, sy at dx, dy, rotated clockwise by
+ * 'angle' (65536 = full turn) and scaled by 'scale' (16.16, 65536 = 1:1) around it.
+ * Returns -1 if scale is too small for the matrix (below 3 = 1/21845), the translation saturates.
+ */
+int LEDmx_AffineRotate(int32_t m[6], uint16_t angle, int32_t scale, int16_t dx, int16_t dy, int16_t sx, int16_t sy)
+{
+    if (scale < 3)
+        return -1;
+
+    int64_t k = ((int64_t)1 << 32) / scale;                 // inverse scale, 16.16, < 2^31
+    int64_t c = (LEDmx_Sin(angle + 0x4000) * k) >> 16;
+    int64_t s = (LEDmx_Sin(angle) * k) >> 16;
+
+    m[0] = (int32_t)c;
+    m[1] = (int32_t)s;
+    m[2] = LEDmx_Saturate32(((int64_t)sx << 16) - c * dx - s * dy);
+    m[3] = (int32_t)-s;
+    m[4] = (int32_t)c;
+    m[5] = LEDmx_Saturate32(((int64_t)sy << 16) + s * dx - c * dy);
+    return 0;
+}
+
+
+
+static int64_t LEDmx_FloorDiv(int64_t n, int64_t d)        // d > 0
+{
+    int64_t q = n / d;
+
+    return (n % d != 0 && n < 0) ? q - 1 : q;
+}
+
+
+
+/*
+ * Narrow the pixels lo..hi of a line to those where a + m * x (16.16) lies in 0 .. size << 16,
+ * false if none is left
+ */
+static bool LEDmx_AffineSpan(int32_t a, int32_t m, int size, int* lo, int* hi)
+{
+    int64_t top = ((int64_t)size << 16) - 1;
+
+    if (m == 0)
+        return a >= 0 && a <= top;
+    if (m > 0)
+    {
+        *lo = (int)max(*lo, -LEDmx_FloorDiv(a, m));
+        *hi = (int)min(*hi, LEDmx_FloorDiv(top - a, m));
+    }
+    else
+    {
+        *lo = (int)max(*lo, -LEDmx_FloorDiv(top - a, -m));
+        *hi = (int)min(*hi, LEDmx_FloorDiv(a, -m));
+    }
+    return *lo <= *hi;
+}
+
+
+
+/*
+ * Draw a bitmap through the affine matrix m (16.16 fixed point), which maps each screen pixel x, y
+ * to the source position m[0] * x + m[1] * y + m[2], m[3] * x + m[4] * y + m[5] (integer values are
+ * pixel centers), see LEDmx_AffineRotate(). Per line the pixels mapping into the bitmap are solved
+ * up front, the source position is then stepped by m[0], m[3] per pixel without bounds tests.
+ * flags: LEDMX_BLIT_KEY, LEDMX_BLIT_OVERLAY (indexed bitmaps) and LEDMX_BLIT_BILINEAR (canvas) as in LEDmx_Blit().
+ */
+void LEDmx_BlitAffine(const ledmxBitmap_t* bmp, const int32_t m[6], int flags)
+{
+    bool overlay = (flags & LEDMX_BLIT_OVERLAY) != 0;
+    bool key = (flags & LEDMX_BLIT_KEY) != 0;
+    bool bilinear = !overlay && (flags & LEDMX_BLIT_BILINEAR) != 0;
+    bool indexed = bmp->format >= LEDMX_BMP_INDEX1;
+    int shift = MAP_888_PWM_SHIFT;
+    uint32_t mask = (0xFF >> shift) * 0x010101;
+
+    if (bmp->w <= 0 || bmp->h <= 0 || (overlay && !indexed) || (!overlay && indexed && bmp->palette == NULL))
+        return;
+
+    for (int y = ledmxClip.t; y <= ledmxClip.b; y++)
+    {
+        int lo = ledmxClip.l, hi = ledmxClip.r;
+        int32_t ax = m[1] * y + m[2] + 0x8000;        // rounded to the nearest source pixel
+        int32_t ay = m[4] * y + m[5] + 0x8000;
+
+        if (!LEDmx_AffineSpan(ax, m[0], bmp->w, &lo, &hi) || !LEDmx_AffineSpan(ay, m[3], bmp->h, &lo, &hi))
+            continue;
+
+        uint32_t* dst = &ledmxActiveImage[y * DISPLAY_WIDTH];
+        int32_t u = ax + m[0] * lo;
+        int32_t v = ay + m[3] * lo;
+
+        for (int x = lo; x <= hi; x++, u += m[0], v += m[3])
+        {
+            int sx = u >> 16, sy = v >> 16;
+            uint32_t raw = LEDmx_BmpRaw(bmp, sx, sy);
+            uint32_t c;
+
+            if (key && raw == bmp->key)
+                continue;
+            if (overlay)
+            {
+                LEDmx_OverlayPut(x, y, raw);
+                continue;
+            }
+            c = indexed ? bmp->palette[raw] : raw;
+            if (bilinear)
+            {
+                // neighbors of the position, clamped at the edges, key pixels take the nearest color
+                int x0 = (u - 0x8000) >> 16, y0 = (v - 0x8000) >> 16;
+                int x1 = min(x0 + 1, bmp->w - 1), y1 = min(y0 + 1, bmp->h - 1);
+                uint32_t fx = ((u - 0x8000) >> 8) & 0xFF, fy = ((v - 0x8000) >> 8) & 0xFF;
+                uint32_t p[4];
+
+                x0 = max(x0, 0);
+                y0 = max(y0, 0);
+                p[0] = LEDmx_BmpColor(bmp, x0, y0);
+                p[1] = LEDmx_BmpColor(bmp, x1, y0);
+                p[2] = LEDmx_BmpColor(bmp, x0, y1);
+                p[3] = LEDmx_BmpColor(bmp, x1, y1);
+                if (key)
+                    for (int i = 0; i < 4; i++)
+                        if ((indexed ? LEDmx_BmpRaw(bmp, (i & 1) ? x1 : x0, (i & 2) ? y1 : y0) : p[i]) == bmp->key)
+                            p[i] = c;
+                c = hub75_alpha_blend(hub75_alpha_blend(p[0], p[1], fx), hub75_alpha_blend(p[2], p[3], fx), fy);
+            }
+            dst[x] = (c >> shift) & mask;
+        }
+    }
+    ledmxCanvasDirty = true;
+}
+
+
+
+/*
+ * Blend a w x h block of ARGB pixels (alpha in bits 24..31) onto the canvas at x, y, clipped.
+ * Line n of the block starts at src + n * srcStride (words). 'premultiplied' pixels have their
+ * color already multiplied with their alpha (see hub75_alpha_premultiply()), which saves the
+ * multiplies of the sprite side. Fully transparent pixels are skipped, opaque ones copied.
+ */
+void LEDmx_BlitAlpha(int16_t x, int16_t y, const uint32_t* src, int w, int h, int srcStride, bool premultiplied)
+{
+    int l = x, t = y, r = x + w - 1, b = y + h - 1;
+    int shift = MAP_888_PWM_SHIFT;
+    uint32_t mask = (0xFF >> shift) * 0x010101;
+
+    if (w <= 0 || h <= 0 || !LEDmx_ClipRect(&l, &t, &r, &b))
+        return;
+    src += (t - y) * srcStride + (l - x);
+
+    for (int row = t; row <= b; row++, src += srcStride)
+    {
+        uint32_t* dst = &ledmxActiveImage[row * DISPLAY_WIDTH + l];
+        const uint32_t* sp = src;
+
+        for (int n = r - l + 1; n > 0; n--, dst++)
+        {
+            uint32_t c = *sp++;
+            uint32_t a = HUB75_ARGB_ALPHA(c);
+
+            if (a == 0)
+                continue;
+            c = (c & 0xFF000000) | ((c >> shift) & mask);
+            if (a == 0xFF)
+                *dst = c & 0xFFFFFF;
+            else if (premultiplied)
+                *dst = hub75_alpha_over(*dst, c);
+            else
+                *dst = hub75_alpha_blend(*dst, c & 0xFFFFFF, hub75_alpha_256(a));
+        }
+    }
+    ledmxCanvasDirty = true;
+}
+
+
+
+/*
+ * DMA fills and blits: a copy of 'words' words per row block. The blocks channel writes the
+ * {read address, write address} pair of each row to the alias 2 registers of the data channel,
+ * the write to WRITE_ADDR_TRIG starts the row. The data channel chains back to the blocks channel
+ * and the null block at the end raises DMA_IRQ_1.
+ */
+static void LEDmx_DMAHandler(void)
+{
+    if (ledmxDmaChan < 0 || !dma_channel_get_irq1_status(ledmxDmaChan))
+        return;
+    dma_channel_acknowledge_irq1(ledmxDmaChan);
+    ledmxCanvasDirty = true;        // fill or blit into the canvas done
+
+    LEDmx_dma_fn done = ledmxDmaDone;
+    ledmxDmaDone = NULL;
+    ledmxDmaBusy = false;
+    if (done != NULL)
+        done(ledmxDmaCtx);
+}
+
+
+
+static bool LEDmx_DMAInit(void)
+{
+    if (ledmxDmaChan >= 0)
+        return true;
+
+    int data = dma_claim_unused_channel(false);
+    if (data < 0)
+        return false;
+    int blocks = dma_claim_unused_channel(false);
+    if (blocks < 0)
+    {
+        dma_channel_unclaim(data);
+        return false;
+    }
+
+    dma_channel_config c = dma_channel_get_default_config(blocks);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, 3);                   // 2 words: al2_read_addr, al2_write_addr_trig
+    dma_channel_configure(blocks, &c, &dma_hw->ch[data].al2_read_addr, ledmxDmaBlocks, 2, false);
+
+    ledmxDmaBlocksChan = blocks;
+    ledmxDmaChan = data;
+    dma_channel_set_irq1_enabled(data, true);
+    irq_add_shared_handler(DMA_IRQ_1, LEDmx_DMAHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+    return true;
+}
+
+
+
+/*
+ * Start the prepared row blocks, 'words' per row. Unpaced: the display channels are paced by the PIO
+ * and still get their turn in the round robin of the DMA.
+ */
+static void LEDmx_DMAStart(int rows, int words, bool readIncrement, LEDmx_dma_fn done, void* ctx)
+{
+    ledmxDmaBlocks[rows][0] = 0;
+    ledmxDmaBlocks[rows][1] = 0;
+
+    dma_channel_config c = dma_channel_get_default_config(ledmxDmaChan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, readIncrement);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_chain_to(&c, ledmxDmaBlocksChan);   // load the next row when a row is done
+    channel_config_set_irq_quiet(&c, true);                 // IRQ only at the null block
+    dma_channel_set_config(ledmxDmaChan, &c, false);
+    dma_channel_set_trans_count(ledmxDmaChan, words, false);
+
+    ledmxDmaDone = done;
+    ledmxDmaCtx = ctx;
+    ledmxDmaBusy = true;
+    dma_channel_set_write_addr(ledmxDmaBlocksChan, &dma_hw->ch[ledmxDmaChan].al2_read_addr, false);
+    dma_channel_set_read_addr(ledmxDmaBlocksChan, ledmxDmaBlocks, true);
+}
+
+
+
+bool LEDmx_DMABusy(void)
+{
+    return ledmxDmaBusy;
+}
+
+
+
+void LEDmx_DMAWait(void)
+{
+    while (ledmxDmaBusy)
+        tight_loop_contents();
+}
+
+
+
+/*
+ * Fill the rectangle like LEDmx_Rect() by DMA and return at once. 'done' is called from the DMA
+ * interrupt when the fill is complete. A previous fill or blit is waited for.
+ * Returns -1 if no DMA channel is free.
+ */
+int LEDmx_FillDMA(int16_t left, int16_t top, int16_t right, int16_t bottom, rgb_t color, LEDmx_dma_fn done, void* ctx)
+{
+    int l = left, t = top, r = right, b = bottom, rows = 0;
+    uint32_t value = 0;
+
+    if (!LEDmx_DMAInit())
+        return -1;
+    LEDmx_DMAWait();
+
+    if (left > right || top > bottom || !LEDmx_ClipRect(&l, &t, &r, &b) || !LEDmx_PixelValue(color, &value))
+        b = t - 1;                  // nothing to draw, only the completion
+
+    ledmxDmaFill = value;
+    if (l == 0 && r == DISPLAY_WIDTH - 1 && t <= b)
+    {
+        // full lines are contiguous: a single block
+        ledmxDmaBlocks[0][0] = (uint32_t)&ledmxDmaFill;
+        ledmxDmaBlocks[0][1] = (uint32_t)&ledmxActiveImage[t * DISPLAY_WIDTH];
+        LEDmx_DMAStart(1, (b - t + 1) * DISPLAY_WIDTH, false, done, ctx);
+        return 0;
+    }
+    for (int y = t; y <= b; y++, rows++)
+    {
+        ledmxDmaBlocks[rows][0] = (uint32_t)&ledmxDmaFill;
+        ledmxDmaBlocks[rows][1] = (uint32_t)&ledmxActiveImage[y * DISPLAY_WIDTH + l];
+    }
+    LEDmx_DMAStart(rows, r - l + 1, false, done, ctx);
+    return 0;
+}
+
+
+
+/*
+ * Copy a w x h block of canvas pixels to x, y by DMA and return at once, clipped to the screen.
+ * Line n of the block starts at src + n * srcStride (words). src must stay valid until 'done' is
+ * called from the DMA interrupt. A previous fill or blit is waited for. Returns -1 if no DMA channel is free.
+ */
+int LEDmx_BlitDMA(int16_t x, int16_t y, const uint32_t* src, int w, int h, int srcStride, LEDmx_dma_fn done, void* ctx)
+{
+    int l = x, t = y, r = x + w - 1, b = y + h - 1, rows = 0;
+
+    if (!LEDmx_DMAInit())
+        return -1;
+    LEDmx_DMAWait();
+
+    if (w <= 0 || h <= 0 || !LEDmx_ClipRect(&l, &t, &r, &b))
+        b = t - 1;
+    src += (t - y) * srcStride + (l - x);
+
+    if (l == 0 && r == DISPLAY_WIDTH - 1 && srcStride == DISPLAY_WIDTH && t <= b)
+    {
+        ledmxDmaBlocks[0][0] = (uint32_t)src;
+        ledmxDmaBlocks[0][1] = (uint32_t)&ledmxActiveImage[t * DISPLAY_WIDTH];
+        LEDmx_DMAStart(1, (b - t + 1) * DISPLAY_WIDTH, true, done, ctx);
+        return 0;
+    }
+    for (int row = t; row <= b; row++, rows++, src += srcStride)
+    {
+        ledmxDmaBlocks[rows][0] = (uint32_t)src;
+        ledmxDmaBlocks[rows][1] = (uint32_t)&ledmxActiveImage[row * DISPLAY_WIDTH + l];
+    }
+    LEDmx_DMAStart(rows, r - l + 1, true, done, ctx);
+    return 0;
+}
+
+
+
+
+void LEDmx_BlankScreen(void)
+{
+    LEDmx_ClearScreen(BLACK);
+    // needs no flush
+}
+
+
+
+
+/*
+ * Clip rectangle of all drawing primitives (inclusive coordinates, limited to the screen).
+ * LEDmx_SetClip() replaces the current one, LEDmx_PushClip() narrows it to the intersection with
+ * l..r, t..b until LEDmx_PopClip(). All take the coordinates in the order l, r, t, b.
+ * LEDmx_ClearScreen() and LEDmx_ClearOverlay() are not clipped.
+ */
+void LEDmx_SetClip(int16_t l, int16_t r, int16_t t, int16_t b)
+{
+    ledmxClip.l = max(l, 0);
+    ledmxClip.t = max(t, 0);
+    ledmxClip.r = min(r, DISPLAY_WIDTH - 1);
+    ledmxClip.b = min(b, DISPLAY_HEIGHT - 1);
+}
+
+
+
+int LEDmx_PushClip(int16_t l, int16_t r, int16_t t, int16_t b)
+{
+    if (ledmxClipDepth >= LEDMX_CLIP_DEPTH)
+        return -1;
+    ledmxClipStack[ledmxClipDepth++] = ledmxClip;
+    ledmxClip.l = max(l, ledmxClip.l);
+    ledmxClip.t = max(t, ledmxClip.t);
+    ledmxClip.r = min(r, ledmxClip.r);
+    ledmxClip.b = min(b, ledmxClip.b);
+    return 0;
+}
+
+
+
+void LEDmx_PopClip(void)
+{
+    if (ledmxClipDepth > 0)
+        ledmxClip = ledmxClipStack[--ledmxClipDepth];
+}
+
+
+
+void LEDmx_ResetClip(void)
+{
+    ledmxClipDepth = 0;
+    LEDmx_SetClip(0, DISPLAY_WIDTH - 1, 0, DISPLAY_HEIGHT - 1);
+}
+
+
+
+void LEDmx_GetClip(int16_t* l, int16_t* r, int16_t* t, int16_t* b)
+{
+    *l = ledmxClip.l;
+    *t = ledmxClip.t;
+    *r = ledmxClip.r;
+    *b = ledmxClip.b;
+}
+
+
+
+uint8_t LEDmx_IsClipped(int16_t x, int16_t y)
+{
+    if ((x < ledmxClip.l) || (x > ledmxClip.r) || (y < ledmxClip.t) || (y > ledmxClip.b))
+        return 1;
+
+    return 0;
+}
+
+
+void LEDmx_ClearOverlay (void)
+{
+    memset (overlayBuffer, 0, sizeof(overlayBuffer));
+    ledmxCanvasDirty = true;
+}
+
+
+void LEDmx_SetOverlayPixel(int x, int y, int color)
+{
+    if (LEDmx_IsClipped(x,y))
+        return;
+    LEDmx_OverlayPut(x, y, color);
+    ledmxCanvasDirty = true;
+}
+
+
+void LEDmx_SetOverlayColor(int index, rgb_t color)
+{
+    hub75_set_overlaycolor(index, color);
+    ledmxCanvasDirty = true;
+}
+
+
+
+#ifdef HUB75_BCM
+void LEDmx_SetOverlayBlend(int index, int mode)
+{
+    hub75_set_overlayblend(index, mode);
+    ledmxCanvasDirty = true;
 }
+#endif
 
 
 
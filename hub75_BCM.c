@@ -27,18 +27,112 @@
 #include "pico/stdlib.h"
 #include "hardware/dma.h"
 #include "hardware/irq.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/regs/xip.h"
+#include "hardware/structs/xip_ctrl.h"
 #include "ps_debug.h"
 #include "hub75.h"
 
 #if HUB75_SIZE == 4040
-uint32_t frameBuffer[DISPLAY_MAXPLANES * (DISPLAY_WIDTH / 4) * DISPLAY_SCAN]; // each entry contains RGB data for 2 or 4 consective pixels on one HUB75 channel
+#define FB_ROW_WORDS    HUB75_64_ROW_WORDS(DISPLAY_WIDTH)   // each entry contains RGB data for 4 consective pixels on one HUB75 channel
+#define FB_PIXEL_BITS   HUB75_64_PIXEL_BITS                 // bits per pixel (column) in a framebuffer word
+#define FB_OE_FLAG      HUB75_64_OE_FLAG                    // OE flag of the first pixel in a framebuffer word
+#define FB_LINES        2                                   // image lines shifted out in one scan row
+#define FB_COLS         4                                   // columns per framebuffer word
+#define FB_COL_REPEAT   0x01010101u                         // one bit in each column of a framebuffer word
 #elif HUB75_SIZE == 8080
-uint32_t frameBuffer[DISPLAY_MAXPLANES * (DISPLAY_WIDTH / 2) * DISPLAY_SCAN]; // each entry contains RGB data for 2 pixels on two HUB75 channels
+#define FB_ROW_WORDS    HUB75_128_ROW_WORDS(DISPLAY_WIDTH)  // each entry contains RGB data for 2 pixels on two HUB75 channels
+#define FB_PIXEL_BITS   HUB75_128_PIXEL_BITS
+#define FB_OE_FLAG      HUB75_128_OE_FLAG
+#define FB_LINES        4
+#define FB_COLS         2
+#define FB_COL_REPEAT   0x00010001u
 #else
     #error "V2 board supports 64x64 or 128x128 layouts"
 #endif
-rgb_t* addrBuffer[(1<<DISPLAY_MAXPLANES)];
+#define FB_PLANE_WORDS  (FB_ROW_WORDS * DISPLAY_SCAN)
+
+#define BCM_PLANES      8       // binary weighted planes, planes beyond are shown once with shortened OE
+#if DISPLAY_MAXPLANES > BCM_PLANES
+#define SHORT_PLANES    (DISPLAY_MAXPLANES - BCM_PLANES)
+#else
+#define SHORT_PLANES    0
+#endif
+#define BCM_MAXSTEPS    ((1 << (DISPLAY_MAXPLANES - SHORT_PLANES)) + SHORT_PLANES)
+
+uint32_t frameBuffer[DISPLAY_MAXPLANES * FB_PLANE_WORDS];
+uint8_t  addrBuffer[BCM_MAXSTEPS];      // bit plane shown in each BCM step (entry 0 is unused)
 uint16_t  bcmCounter = 1;     // index in addrBuffer array
+static uint16_t bcmSteps = BCM_MAXSTEPS;   // end of the addrBuffer entries in use
+static int shortPlanes = SHORT_PLANES;      // deep colour planes in use (bitPlanes - BCM_PLANES)
+static int bcmChunks = 0;                   // MSB split of the plane schedule, 0 = every other step
+static int rowOrder = HUB75_ROWS_LINEAR;    // scan order of the rows within a BCM step
+static uint8_t rowAt[DISPLAY_SCAN];         // row address shifted out at framebuffer row position p
+static uint8_t rowPos[DISPLAY_SCAN];        // framebuffer row position of scan row y
+
+static uint32_t* volatile displayFrame = frameBuffer;  // frame currently read by the display DMA
+static uint32_t* volatile nextFrame = frameBuffer;     // frame to be shown from the next BCM cycle on
+
+static const hub75_anim_t* volatile anim = NULL;       // animation played by the display DMA interrupt
+static uint16_t     animFrame;
+static uint16_t     animTicks;
+static int          animFlags;
+static int          animStageChan = -1;                 // DMA channel reading the XIP stream FIFO
+static uint32_t*    animStage[2];                       // RAM buffers of staged playback
+static int          animStageIdx;                       // buffer the next frame is staged into
+
+static void hub75_anim_tick(void);
+
+#define FRC_MAXPHASES   4
+static int          frcRequest = 0;                     // phases asked for by hub75_set_frc()
+static int          frcPhases = 0;                      // phase frames in use, 0 = temporal dithering off
+static int          frcBits = 0;                        // discarded color bits spread over the phases
+static int          frcPhase = 0;                       // phase frame on screen
+static uint32_t*    frcFrame[FRC_MAXPHASES];            // phase frames, [0] is frameBuffer
+static int          frcPoolWords = 0;                   // words of the cache pool used by phase frames
+
+static void hub75_frc_setup(void);
+
+// Row elision: scan rows that are black in all planes are not shifted out, see hub75_set_elision()
+#define ROWS_ALL        0xFFFFFFFFu     // one bit per framebuffer row position (DISPLAY_SCAN = 32)
+#define ELIDE_MINROWS   12              // the 8 word ctrl FIFO must not run ahead more than one BCM step
+#define ELIDE_MINOE     8               // min. OE columns left after scaling the OE window
+static int          elideMode = HUB75_ELIDE_OFF;
+static uint32_t     fbLit = 0;                          // row positions of frameBuffer with lit pixels
+static int          fbOeRows = DISPLAY_SCAN;            // rows per step the OE flags of frameBuffer are scaled for
+static volatile uint32_t fbKeep = ROWS_ALL;             // row positions of frameBuffer shifted out
+static uint32_t     dispKeep = ROWS_ALL;                // row positions of displayFrame shifted out
+static int          dispRuns = 1;                       // runs of shifted rows of displayFrame
+static uint16_t     runOffset[DISPLAY_SCAN];            // start (words) and length (words) of each run in a plane
+static uint16_t     runWords[DISPLAY_SCAN] = { FB_PLANE_WORDS };
+static uint32_t     dmaBlocks[2 * (DISPLAY_SCAN + 1)] __attribute__((aligned(8)));    // {count, read address} ..., {0, 0}
+static uint32_t     ctrlRows[2][DISPLAY_SCAN];          // row address lists of elided frames
+static int          ctrlRowsIdx;
+static const uint32_t* ctrlList;                        // row address list of the ctrl DMA
+static int          ctrlCount = DISPLAY_SCAN;
+static const uint32_t* ctrlNextList;                    // address list taking over at BCM step ctrlSwitchSeq
+static int          ctrlNextCount;
+static bool         ctrlPending = false;
+static uint32_t     ctrlSwitchSeq;
+static uint32_t     dataSeq, ctrlSeq;                   // last BCM step started by the data and the ctrl DMA
+
+static uint8_t      rowMaps[2][DISPLAY_SCAN];           // scan row whose data is shown on scan row y
+static const uint8_t* rowMap = NULL;                    // row map of the display DMA, NULL = identity
+static const uint8_t* volatile rowMapNext = NULL;       // row map set by hub75_set_rowmap()
+static volatile bool rowMapPending = false;             // rowMapNext takes over at the end of the BCM cycle
+
+static void hub75_elide_rows(void);
+
+static uint32_t*    tickerStrip = NULL;                 // encoded ticker band, NULL = no ticker
+static int          tickerTop, tickerHeight;            // image lines of the band
+static int          tickerWidth;                        // columns of the strip, multiple of FB_COLS
+static int          tickerStride;                       // words between the planes of a strip line
+static int          tickerPlanes;                       // bitPlanes the strip is encoded for
+static volatile int32_t tickerPos = 0;                  // 16.16 strip column at the left screen edge
+static int          tickerCol = 0;                      // strip column of the rows encoded in this pass, see hub75_ticker_latch()
+static int32_t      tickerSpeed = 0;                    // 16.16 columns per BCM cycle
+
+static void hub75_ticker_advance(void);
 
 uint32_t ctrlBuffer[DISPLAY_MAXPLANES * DISPLAY_SCAN]; // N bit planes * # of scan lines
 
@@ -53,8 +147,126 @@ static uint display_offset_ctrl;
 
 static int display_dma_chan;
 static int ctrl_dma_chan;
+static int blocks_dma_chan;        // feeds the control blocks (rows to shift) of each step to the display DMA
+
+static rgb_t overlayColors[256];
+static uint8_t overlayBlend[256];               // HUB75_BLEND_xxx of each overlay color
+static int overlayFormat = HUB75_OVERLAY_BYTE;
+
+static hub75_lut_t colorLut;            // color correction tables, see hub75_set_colorcorrection()
+static bool colorActive = false;        // false while the correction leaves colors unchanged
+
+typedef rgb_t scanLine_t[DISPLAY_WIDTH];
+
+static scanLine_t lineBuffer[FB_LINES];     // image lines of the scan row being encoded
+static scanLine_t lineBufferLo[FB_LINES];   // 8 bits below the MSBs of 16 bit per channel image lines
+static scanLine_t frcLines[FB_LINES];       // lines of one temporal dithering phase
+static scanLine_t tickerLines[FB_LINES];    // chunk of a ticker band line being encoded
+static scanLine_t tickerLinesLo[FB_LINES];
+
+static int ditherMode = HUB75_DITHER_NONE;
+static int16_t ditherErr[FB_LINES][HUB75_DITHER_ERR_SIZE(DISPLAY_WIDTH)];    // error diffusion of each line stream
+static uint32_t oeMask[1 + SHORT_PLANES][FB_ROW_WORDS];   // OE flags of one framebuffer row: [0] full, [n] OE shortened to 1/2^n
+
+
+/*
+ * Start the display DMA on the row runs of one bit plane. The display channel raises its
+ * interrupt when the blocks channel writes the terminating null block.
+ */
+static void hub75_start_step(const uint32_t* plane)
+{
+    uint32_t* b = dmaBlocks;
+
+    for (int i = 0; i < dispRuns; i++)
+    {
+        *b++ = runWords[i];
+        *b++ = (uint32_t)(plane + runOffset[i]);
+    }
+    b[0] = b[1] = 0;
+    dma_channel_set_read_addr(blocks_dma_chan, dmaBlocks, true);
+    dataSeq++;
+}
+
+
+
+/*
+ * Row runs of the row map: shift position p keeps the row address rowAt[p] of ctrlBuffer and
+ * shifts the data of scan row rowMap[rowAt[p]]. Consecutive source rows merge into one run.
+ */
+static void hub75_rowmap_runs(void)
+{
+    dispRuns = 0;
+    for (int p = 0; p < DISPLAY_SCAN; p++)
+    {
+        int src = rowPos[rowMap[rowAt[p]]] * FB_ROW_WORDS;
+
+        if (dispRuns > 0 && runOffset[dispRuns - 1] + runWords[dispRuns - 1] == src)
+            runWords[dispRuns - 1] += FB_ROW_WORDS;
+        else
+        {
+            runOffset[dispRuns] = src;
+            runWords[dispRuns++] = FB_ROW_WORDS;
+        }
+    }
+}
+
+
+
+/*
+ * Called at the end of a BCM cycle: take over the shifted rows of the new displayFrame and a new row map.
+ * The ctrl DMA runs ahead of the data DMA, it switches its address list at the same BCM step.
+ */
+static void hub75_elide_switch(void)
+{
+    bool remap = rowMapPending;
+
+    if (remap)
+    {
+        rowMap = rowMapNext;
+        rowMapPending = false;
+    }
+
+    uint32_t keep = (displayFrame == frameBuffer && rowMap == NULL) ? fbKeep : ROWS_ALL;
+
+    if (keep == dispKeep && !remap)
+        return;
+    dispKeep = keep;
+
+    const uint32_t* list = ctrlBuffer;
+    int n = DISPLAY_SCAN;
+    dispRuns = 0;
+    if (rowMap != NULL)
+        hub75_rowmap_runs();            // all rows, elision is off while a row map is set
+    else if (keep == ROWS_ALL)
+    {
+        runOffset[dispRuns] = 0;
+        runWords[dispRuns++] = FB_PLANE_WORDS;
+    }
+    else
+    {
+        uint32_t* rows = ctrlRows[ctrlRowsIdx ^= 1];
+
+        n = 0;
+        for (int p = 0; p < DISPLAY_SCAN; p++)
+        {
+            if (!(keep & (1u << p)))
+                continue;
+            if (p == 0 || !(keep & (1u << (p - 1))))
+            {
+                runOffset[dispRuns] = p * FB_ROW_WORDS;
+                runWords[dispRuns++] = 0;
+            }
+            runWords[dispRuns - 1] += FB_ROW_WORDS;
+            rows[n++] = ctrlBuffer[p];
+        }
+        list = rows;
+    }
+    ctrlNextList = list;
+    ctrlNextCount = n;
+    ctrlSwitchSeq = dataSeq + 1;    // first step of the next BCM cycle
+    ctrlPending = true;
+}
 
-static rgb_t overlayColors[16];
 
 
 static void dma_hub75_handler()
@@ -64,18 +276,38 @@ static void dma_hub75_handler()
     {
         dma_hw->ints0 = 1u << display_dma_chan;
         // start next display cycle
-        dma_channel_set_read_addr(display_dma_chan, addrBuffer[bcmCounter], true);
-        if (++bcmCounter >= (1 << bitPlanes))
+        hub75_start_step(displayFrame + addrBuffer[bcmCounter] * FB_PLANE_WORDS);
+        if (++bcmCounter >= bcmSteps)
         {
             gpio_xor_mask(1<<15);       // debug LED for frame time measurement
             bcmCounter = 1;
+            if (anim != NULL)
+                hub75_anim_tick();
+            if (tickerSpeed != 0)
+                hub75_ticker_advance();
+            displayFrame = nextFrame;   // switch frames only between two complete BCM cycles
+            if (frcPhases > 1 && nextFrame == frameBuffer && anim == NULL)
+            {
+                if (++frcPhase >= frcPhases)
+                    frcPhase = 0;
+                displayFrame = frcFrame[frcPhase];
+            }
+            hub75_elide_switch();
         }
     }
     if (dma_hw->ints0 & (1u << ctrl_dma_chan))
     {
         dma_hw->ints0 = 1u << ctrl_dma_chan;
         // start next display cycle
-        dma_channel_set_read_addr(ctrl_dma_chan, &ctrlBuffer[0], true);
+        ctrlSeq++;
+        if (ctrlPending && (int32_t)(ctrlSeq - ctrlSwitchSeq) >= 0)
+        {
+            ctrlList = ctrlNextList;
+            ctrlCount = ctrlNextCount;
+            ctrlPending = false;
+        }
+        dma_channel_set_trans_count(ctrl_dma_chan, ctrlCount, false);
+        dma_channel_set_read_addr(ctrl_dma_chan, ctrlList, true);
     }
 }
 
@@ -154,11 +386,14 @@ static void hub75_init()
 
     // Initialize data port DMA
     display_dma_chan = dma_claim_unused_channel(true);
+    blocks_dma_chan = dma_claim_unused_channel(true);
     dma_channel_config c = dma_channel_get_default_config(display_dma_chan);
     channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
     channel_config_set_read_increment(&c, true);
     channel_config_set_write_increment(&c, false);
     channel_config_set_dreq(&c, DREQ_PIO0_TX0 + display_sm_data);
+    channel_config_set_chain_to(&c, blocks_dma_chan);      // load the next row run when a run is done
+    channel_config_set_irq_quiet(&c, true);                 // IRQ only at the null block ending a step
 
     //    channel_config_set_ring(&c, false, 15);     // ring size is 8192
 
@@ -167,15 +402,28 @@ static void hub75_init()
         &c,
         &pio0_hw->txf[display_sm_data],
         NULL,  // Will be set later for each transfer
-#if HUB75_SIZE == 4040
-        DISPLAY_SCAN * ((DISPLAY_WIDTH / 4)),     // complete frame buffer for 1 bit plane
-#elif HUB75_SIZE == 8080
-        DISPLAY_SCAN* ((DISPLAY_WIDTH / 2)),     // complete frame buffer for 1 bit plane
-#endif
+        FB_PLANE_WORDS,     // complete frame buffer for 1 bit plane
         false
     );
     dma_channel_set_irq0_enabled(display_dma_chan, true);
 
+    // Control blocks of the data port DMA: {transfer count, read address} pairs written to the
+    // alias 3 registers of the display channel, the write to READ_ADDR_TRIG starts the run
+    c = dma_channel_get_default_config(blocks_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, 3);                   // 2 words: al3_transfer_count, al3_read_addr_trig
+
+    dma_channel_configure(
+        blocks_dma_chan,
+        &c,
+        &dma_hw->ch[display_dma_chan].al3_transfer_count,
+        dmaBlocks,
+        2,
+        false
+    );
+
     // Initialize control port DMA
     ctrl_dma_chan = dma_claim_unused_channel(true);
     c = dma_channel_get_default_config(ctrl_dma_chan);
@@ -203,7 +451,19 @@ static void hub75_init()
 
 static void hub75_start()
 {
-    dma_channel_set_read_addr(display_dma_chan, frameBuffer, true);
+    dispKeep = fbKeep = ROWS_ALL;
+    dispRuns = 1;
+    runOffset[0] = 0;
+    runWords[0] = FB_PLANE_WORDS;
+    ctrlList = ctrlBuffer;
+    ctrlCount = DISPLAY_SCAN;
+    ctrlPending = false;
+    rowMap = rowMapNext = NULL;
+    rowMapPending = false;
+    dataSeq = 0;
+    ctrlSeq = 1;        // the first step of the ctrl DMA is started below
+
+    hub75_start_step(frameBuffer);
     dma_channel_set_read_addr(ctrl_dma_chan, ctrlBuffer, true);
 }
 
@@ -211,10 +471,12 @@ static void hub75_start()
 
 void hub75_config(int bpp)
 {
-    if (bpp < 4) bpp = 4;
-    if (bpp > 8) bpp = 8;
+    if (bpp < 1) bpp = 1;
+    if (bpp > DISPLAY_MAXPLANES) bpp = DISPLAY_MAXPLANES;
 
     bitPlanes = bpp;
+    shortPlanes = (bpp > BCM_PLANES) ? bpp - BCM_PLANES : 0;
+    tickerStrip = NULL;                 // encoded for the former number of planes
 
     irq_set_enabled(DMA_IRQ_0, false);      // stop interrupts on DMA channels
     gpio_init(DISPLAY_OENPIN);          // switch display OFF
@@ -237,6 +499,12 @@ void hub75_config(int bpp)
 
     pio_clear_instruction_memory(display_pio);
 
+    if (dma_channel_is_claimed(blocks_dma_chan))
+    {
+        dma_channel_abort(blocks_dma_chan);
+        dma_channel_unclaim(blocks_dma_chan);
+    }
+
     if (dma_channel_is_claimed(display_dma_chan))
     {
         dma_channel_abort(display_dma_chan);
@@ -257,32 +525,40 @@ void hub75_config(int bpp)
     irq_remove_handler(DMA_IRQ_0, dma_hub75_handler);
 
 
-#if HUB75_SIZE == 4040
-    memset(frameBuffer, 0, bitPlanes * (DISPLAY_WIDTH / 4) * DISPLAY_SCAN * sizeof(uint32_t));
-#elif HUB75_SIZE == 8080
-    memset(frameBuffer, 0, bitPlanes * (DISPLAY_WIDTH / 2) * DISPLAY_SCAN * sizeof(uint32_t));
-#else
-    #error "V2 board supports 64x64 or 128x128 layouts"
-#endif
+    memset(frameBuffer, 0, bitPlanes * FB_PLANE_WORDS * sizeof(uint32_t));
+    fbLit = 0;
+    fbOeRows = DISPLAY_SCAN;
     memset(ctrlBuffer, 0, bitPlanes * DISPLAY_SCAN * sizeof(uint32_t));
-    memset(addrBuffer, 0, (1<<bitPlanes) * sizeof(uint32_t*));
-    
-    for (int bPos = 0; bPos < bitPlanes; bPos++)
+    hub75_row_order(rowAt, DISPLAY_SCAN, rowOrder);
+    for (int p = 0; p < DISPLAY_SCAN; p++)
+        rowPos[rowAt[p]] = p;
+    for (int i = 0; i < bitPlanes * DISPLAY_SCAN; i++)
+        ctrlBuffer[i] = (rowAt[i % DISPLAY_SCAN] & 0x1F);             // ADDR lines: bits 0..4
+    memset(addrBuffer, 0xFF, sizeof(addrBuffer));
+
+    int bcmPlanes = bitPlanes - shortPlanes;
+    int lsbStep = 1;
+    hub75_bcm_schedule(&addrBuffer[1], bcmPlanes, bcmChunks);
+    for (int i = 1; i < (1<<bcmPlanes); i++)
     {
-        for (int i = 1; i < (1<<bitPlanes); i++)
-        {
-            if (i & (1 << bPos) && (addrBuffer[i] == 0))
-            {
-                LOG_DEBUG("addrBuffer[%3d] = plane %d\n", i, (bitPlanes - bPos));
-#if HUB75_SIZE == 4040
-                addrBuffer[i] = &frameBuffer[(bitPlanes - 1 - bPos) * (DISPLAY_WIDTH / 4) * DISPLAY_SCAN];
-#elif HUB75_SIZE == 8080
-                addrBuffer[i] = &frameBuffer[(bitPlanes - 1 - bPos) * (DISPLAY_WIDTH / 2) * DISPLAY_SCAN];
-#endif
-            }
-        }
+        addrBuffer[i] += shortPlanes;       // binary planes follow the short planes in the framebuffer
+        if (addrBuffer[i] == shortPlanes)
+            lsbStep = i;
+        LOG_DEBUG("addrBuffer[%3d] = plane %d\n", i, addrBuffer[i]);
     }
 
+    // Deep colour: each short plane is shown once, right before the only step of the binary LSB plane.
+    // OE is driven by the row shifted out after the displayed one, so row 0 of a plane carries the OE
+    // flags of the plane shown before it (see hub75_encode_row). This fixed order makes that unique.
+    memmove(&addrBuffer[lsbStep + shortPlanes], &addrBuffer[lsbStep], (1 << bcmPlanes) - lsbStep);
+    for (int n = 0; n < shortPlanes; n++)
+        addrBuffer[lsbStep + n] = shortPlanes - 1 - n;      // longest OE first
+    bcmSteps = (1 << bcmPlanes) + shortPlanes;
+
+    hub75_anim_stop();
+    displayFrame = nextFrame = frameBuffer;
+    hub75_frc_setup();                      // phase frames and cached frames depend on the number of planes
+
     hub75_init();
     hub75_start();
 }
@@ -290,227 +566,1318 @@ void hub75_config(int bpp)
 
 void  hub75_set_masterbrightness(int brt)
 {
-    brt += 4;       // OE will be always HIGH during the last 4 pixels
-    if (brt < 4) brt = 4;
-    if (brt > (DISPLAY_WIDTH - 1)) brt = (DISPLAY_WIDTH - 1);
-    masterBrightness = brt;
+    masterBrightness = hub75_brightness_limit(brt, DISPLAY_WIDTH);
 }
 
 
 
 void hub75_set_overlaycolor(int index, rgb_t color)
 {
-    if (index < 1 || index > 15)    // index 0 is used internally for 'no overlay'
+    if (index < 1 || index > 255)   // index 0 is used internally for 'no overlay'
         return;
     overlayColors[index] = color;
 }
 
 
 
+void hub75_set_overlayblend(int index, int mode)
+{
+    if (index < 1 || index > 255 || mode < HUB75_BLEND_REPLACE || mode > HUB75_BLEND_MIX)
+        return;
+    overlayBlend[index] = mode;
+}
+
+
+
+void hub75_set_overlayformat(int format)
+{
+    if (format == HUB75_OVERLAY_BYTE || format == HUB75_OVERLAY_NIBBLE)
+        overlayFormat = format;
+}
+
+
+
+void hub75_set_schedule(int chunks, int order)
+{
+    bcmChunks = chunks;
+    if (order >= HUB75_ROWS_LINEAR && order <= HUB75_ROWS_BITREV)
+        rowOrder = order;
+}
+
+
+
+void hub75_set_elision(int mode)
+{
+    if (mode != HUB75_ELIDE_OFF && mode != HUB75_ELIDE_ROWS)
+        return;
+    elideMode = mode;
+    hub75_elide_rows();         // applied to the frame on screen, shown from the next BCM cycle on
+}
+
+
+
+void hub75_set_dither(int mode)
+{
+    if (mode >= HUB75_DITHER_NONE && mode <= HUB75_DITHER_FS)
+        ditherMode = mode;
+}
+
+
+
+void hub75_set_colorcorrection(const hub75_color_t* cc)
+{
+    colorActive = !hub75_color_identity(cc);
+    if (colorActive)
+        hub75_color_lut(&colorLut, cc);
+}
+
+
+
+/*
+ * Pack color bits firstBit.. of the given scan row lines into 'planes' consecutive bit planes
+ */
+static void hub75_pack_planes(uint32_t* dst, int planeStride, scanLine_t* lines, int firstBit, int planes,
+    const uint32_t* oe)
+{
 #if HUB75_SIZE == 4040
-int hub75_update(rgb_t *image, uint8_t *overlay)
+    hub75_pack_row_64(dst, planeStride, lines[0], lines[1], FB_ROW_WORDS, firstBit, planes, oe);
+#elif HUB75_SIZE == 8080
+    hub75_pack_row_128(dst, planeStride, lines[0], lines[1], lines[2], lines[3], FB_ROW_WORDS, firstBit, planes, oe);
+#endif
+}
+
+
+
+/*
+ * Pack the fetched lines of a scan row into all bit planes.
+ * dst points to the row in plane 0 (LSB plane in use), planeStride is the distance to the same row of the next plane.
+ * pos is the position of the row within the BCM step (see rowAt).
+ * lo holds the color bits below the 8 MSBs for the deep colour planes (lines itself for RGB888 images).
+ */
+static void hub75_encode_row(uint32_t* dst, int planeStride, int pos, scanLine_t* lines, scanLine_t* lo)
+{
+    if (shortPlanes == 0)
+    {
+        hub75_pack_planes(dst, planeStride, lines, 8 - bitPlanes, bitPlanes, oeMask[0]);
+        return;
+    }
+
+    // The OE flags of the first row time the last row of the previous BCM step, i.e. they must be the ones
+    // of the plane shown before: the next longer short plane, for the binary LSB plane the shortest one.
+    int prev = (pos == 0) ? 1 : 0;
+
+    for (int n = 0; n < shortPlanes; n++)       // bits 16 - bitPlanes + n of the 16 bit color
+        hub75_pack_planes(dst + n * planeStride, planeStride, lo, 16 - bitPlanes + n, 1, oeMask[shortPlanes - n - prev]);
+    dst += shortPlanes * planeStride;
+    hub75_pack_planes(dst, planeStride, lines, 0, 1, oeMask[prev * shortPlanes]);
+    hub75_pack_planes(dst + planeStride, planeStride, lines, 1, BCM_PLANES - 1, oeMask[0]);
+}
+
+
+
+/*
+ * Copy one image line into the line buffer and blend the overlay pixels onto it
+ */
+static void hub75_fetch_line(rgb_t* dst, const rgb_t* ip, const uint8_t* op)
+{
+    memcpy(dst, ip, DISPLAY_WIDTH * sizeof(rgb_t));
+    if (op != NULL)
+        hub75_overlay_line(dst, op, DISPLAY_WIDTH, overlayFormat, overlayColors, overlayBlend);
+}
+
+
+
+/*
+ * Row generator of hub75_update(): image line with overlay
+ */
+typedef struct imageSource_s {
+    const rgb_t*    image;
+    const uint8_t*  overlay;
+} imageSource_t;
+
+static void hub75_image_line(int y, rgb_t* line, void* ctx)
+{
+    imageSource_t* src = (imageSource_t*)ctx;
+
+    hub75_fetch_line(line, src->image + y * DISPLAY_WIDTH,
+        src->overlay ? src->overlay + y * HUB75_OVERLAY_STRIDE(DISPLAY_WIDTH, overlayFormat) : NULL);
+}
+
+
+
+/*
+ * Spatial dithering of the fetched scan row y down to bitPlanes bits. Each line l belongs to
+ * the stream of image lines l * DISPLAY_SCAN.. which is fetched top down, so it has its own error buffer.
+ */
+static void hub75_dither_row(int y)
+{
+    if (ditherMode == HUB75_DITHER_NONE || bitPlanes >= 8 || frcPhases > 1)
+        return;
+
+    for (int l = 0; l < FB_LINES; l++)
+    {
+        if (ditherMode == HUB75_DITHER_ORDERED)
+            hub75_dither_ordered(lineBuffer[l], DISPLAY_WIDTH, y + l * DISPLAY_SCAN, bitPlanes);
+        else
+        {
+            if (y == 0)
+                memset(ditherErr[l], 0, sizeof(ditherErr[l]));
+            hub75_dither_fs(lineBuffer[l], DISPLAY_WIDTH, bitPlanes, ditherErr[l]);
+        }
+    }
+}
+
+
+
+/*
+ * Fetch all image lines shifted out together in scan row y (upper and lower half of each HUB75 port)
+ * and apply the color correction and dithering. Returns the lines holding the color bits below the 8 MSBs.
+ */
+static scanLine_t* hub75_fetch_row(int y, hub75_row_fn rowFn, void* ctx)
+{
+    scanLine_t* lo = lineBuffer;        // RGB888 is expanded by bit replication
+
+    for (int l = 0; l < FB_LINES; l++)
+        rowFn(y + l * DISPLAY_SCAN, lineBuffer[l], ctx);
+
+    if (colorActive)
+    {
+        for (int l = 0; l < FB_LINES; l++)
+            hub75_color_line(&colorLut, lineBuffer[l], lineBuffer[l], shortPlanes ? lineBufferLo[l] : NULL, DISPLAY_WIDTH);
+        lo = lineBufferLo;
+    }
+    hub75_dither_row(y);
+    return lo;
+}
+
+
+
+/*
+ * Take the scroll position for the rows of one encoding pass. The interrupt advances tickerPos every
+ * BCM cycle, a pass takes several, so reading it per row would shear the band.
+ */
+static void hub75_ticker_latch(void)
+{
+    tickerCol = tickerPos >> 16;
+}
+
+
+
+/*
+ * Copy the ticker lines of scan row y into an encoded row: dst is the row in the first plane, the planes
+ * are planeStride apart. Only the color bits of the band lines are replaced, so the other lines shifted
+ * out in the same scan row and the OE flags stay as encoded. The strip is read from column tickerCol on,
+ * wrapping around at its end; a column offset within a word is a funnel shift of two strip words.
+ */
+static void hub75_ticker_row(uint32_t* dst, int planeStride, int y)
 {
-    int x, y, b, plane;
-    rgb_t* ip;
-    rgb_t* fp, * cp;
-    uint8_t flag = 0;
-    uint8_t brtCnt = 0;
+    uint32_t* strip = tickerStrip;
+    int col = tickerCol;
+    int words = tickerWidth / FB_COLS;
+    int shift = (col % FB_COLS) * FB_PIXEL_BITS;
+
+    if (strip == NULL || tickerPlanes != bitPlanes)
+        return;
 
-    for (b = (8 - bitPlanes); b < 8; b++)     // only MSB bits of RGB color
+    for (int l = 0; l < FB_LINES; l++)
     {
-        ip = image;
-        fp = &frameBuffer[(b - (8 - bitPlanes)) * DISPLAY_SCAN * (DISPLAY_WIDTH / 4)];
-        cp = &ctrlBuffer[(b - (8 - bitPlanes)) * DISPLAY_SCAN];
+        int i = y + l * DISPLAY_SCAN - tickerTop;        // line of the band
+        uint32_t mask = FB_COL_REPEAT * (7u << (3 * l));
 
-        for (y = 0; y < DISPLAY_SCAN; y++)
+        if (i < 0 || i >= tickerHeight)
+            continue;
+        for (int p = 0; p < bitPlanes; p++)
         {
-            rgb_t* ip_uu = image + (y * DISPLAY_WIDTH);
-            rgb_t* ip_lu = image + ((y + DISPLAY_SCAN) * DISPLAY_WIDTH);
-            uint8_t* op_uu = overlay + (y * DISPLAY_WIDTH);
-            uint8_t* op_lu = overlay + ((y + DISPLAY_SCAN) * DISPLAY_WIDTH);
+            const uint32_t* src = &strip[(i * bitPlanes + p) * tickerStride];
+            uint32_t* d = dst + p * planeStride;
+            int q = col / FB_COLS;
 
-            brtCnt = 0;
-            for (x = 0; x < DISPLAY_WIDTH / 4; x++)     // 4 pixels per framebuffer word
+            for (int x = 0; x < FB_ROW_WORDS; x++)
             {
-                rgb_t ipu = *ip_uu++;
-                rgb_t ipl = *ip_lu++;
-
-                if (*op_uu != 0)
-                    ipu = overlayColors[*op_uu];
-                op_uu++;
-                if (*op_lu != 0)
-                    ipl = overlayColors[*op_lu];
-                op_lu++;
-                
-                rgb_t img = (((ipu & (1 << b)) >> b) << 2 |
-                    (((ipu >> 8) & (1 << b)) >> b) << 1 |
-                    ((ipu >> 16) & (1 << b)) >> b) |
-                    ((((ipl & (1 << b)) >> b) << 2 |
-                        (((ipl >> 8) & (1 << b)) >> b) << 1 |
-                        (((ipl >> 16) & (1 << b))) >> b) << 3);
-                if (++brtCnt > masterBrightness)
-                    img |= (1 << 7);
-
-                ipu = *ip_uu++;
-                ipl = *ip_lu++;
-                if (*op_uu != 0)
-                    ipu = overlayColors[*op_uu];
-                op_uu++;
-                if (*op_lu != 0)
-                    ipl = overlayColors[*op_lu];
-                op_lu++;
-                img |= ((((ipu & (1 << b)) >> b) << 2 |
-                    (((ipu >> 8) & (1 << b)) >> b) << 1 |
-                    ((ipu >> 16) & (1 << b)) >> b) |
-                    ((((ipl & (1 << b)) >> b) << 2 |
-                        (((ipl >> 8) & (1 << b)) >> b) << 1 |
-                        (((ipl >> 16) & (1 << b))) >> b) << 3)) << 8;
-                if (++brtCnt > masterBrightness)
-                    img |= (1 << 15);
-
-                ipu = *ip_uu++;
-                ipl = *ip_lu++;
-                if (*op_uu != 0)
-                    ipu = overlayColors[*op_uu];
-                op_uu++;
-                if (*op_lu != 0)
-                    ipl = overlayColors[*op_lu];
-                op_lu++;
-                img |= ((((ipu & (1 << b)) >> b) << 2 |
-                    (((ipu >> 8) & (1 << b)) >> b) << 1 |
-                    ((ipu >> 16) & (1 << b)) >> b) |
-                    ((((ipl & (1 << b)) >> b) << 2 |
-                        (((ipl >> 8) & (1 << b)) >> b) << 1 |
-                        (((ipl >> 16) & (1 << b))) >> b) << 3)) << 16;
-                if (++brtCnt > masterBrightness)
-                    img |= (1 << 23);
-
-                ipu = *ip_uu++;
-                ipl = *ip_lu++;
-                if (*op_uu != 0)
-                    ipu = overlayColors[*op_uu];
-                op_uu++;
-                if (*op_lu != 0)
-                    ipl = overlayColors[*op_lu];
-                op_lu++;
-                img |= ((((ipu & (1 << b)) >> b) << 2 |
-                    (((ipu >> 8) & (1 << b)) >> b) << 1 |
-                    ((ipu >> 16) & (1 << b)) >> b) |
-                    ((((ipl & (1 << b)) >> b) << 2 |
-                        (((ipl >> 8) & (1 << b)) >> b) << 1 |
-                        (((ipl >> 16) & (1 << b))) >> b) << 3)) << 24;
-                if (++brtCnt > masterBrightness)
-                    img |= (1 << 31);
-          
-                *fp++ = img;
-            }
+                int n = (q + 1 < words) ? q + 1 : 0;
+                uint32_t v = shift ? (src[q] >> shift) | (src[n] << (32 - shift)) : src[q];
 
-            uint32_t ctrl = ((y) & 0x1F);                           // ADDR lines: bits 0..4
-
-            *cp++ = ctrl;
+                d[x] = (d[x] & ~mask) | (v & mask);
+                q = n;
+            }
         }
     }
+}
 
-    return 0;
+
+
+/*
+ * Framebuffer row positions holding ticker lines, they are never elided
+ */
+static uint32_t hub75_ticker_rows(void)
+{
+    uint32_t rows = 0;
+
+    for (int i = 0; tickerStrip != NULL && i < tickerHeight; i++)
+        rows |= 1u << rowPos[(tickerTop + i) % DISPLAY_SCAN];
+    return rows;
 }
 
 
-#elif HUB75_SIZE == 8080
-int hub75_update(rgb_t* image, uint8_t* overlay)
+
+/*
+ * Color bits shown by the binary planes in use: a pixel without any of them is black
+ */
+static rgb_t hub75_lit_bits(void)
+{
+    return ((0xFFu << (bitPlanes < 8 ? 8 - bitPlanes : 0)) & 0xFF) * 0x010101u;
+}
+
+
+
+static bool hub75_elide_active(void)
 {
-    int x, y, b, plane;
-    rgb_t* ip;
-    uint32_t* fp, * cp;
-    uint8_t flag = 0;
-    uint8_t brtCnt = 0;
+    return elideMode != HUB75_ELIDE_OFF && shortPlanes == 0 && frcPhases <= 1 && rowMapNext == NULL;
+}
 
-    for (b = (8 - bitPlanes); b < 8; b++)     // only MSB bits of RGB color
-    {
-        ip = image;
-        fp = &frameBuffer[(b - (8 - bitPlanes)) * DISPLAY_SCAN * (DISPLAY_WIDTH / 2)];
-        cp = &ctrlBuffer[(b - (8 - bitPlanes)) * DISPLAY_SCAN];
 
-        for (y = 0; y < DISPLAY_SCAN; y++)
+
+/*
+ * OE brightness value of a frame shifting 'rows' scan rows per BCM step: each row is shown for
+ * DISPLAY_SCAN / rows of the normal time, so the OE window shrinks by rows / DISPLAY_SCAN.
+ */
+static int hub75_elide_brightness(int rows)
+{
+    int on = (DISPLAY_WIDTH - 4) - masterBrightness;
+
+    if (rows >= DISPLAY_SCAN)
+        return masterBrightness;
+    return (DISPLAY_WIDTH - 4) - (on * rows + DISPLAY_SCAN / 2) / DISPLAY_SCAN;
+}
+
+
+
+/*
+ * Select the row positions of frameBuffer to shift out: all rows with lit pixels, padded to the
+ * minimum step length. Rescales the OE flags of frameBuffer when the number of rows changes.
+ * Not while an animation runs, a staged one owns frameBuffer; the next update applies the elision.
+ */
+static void hub75_elide_rows(void)
+{
+    uint32_t keep = ROWS_ALL;
+    int on = (DISPLAY_WIDTH - 4) - masterBrightness;
+
+    if (anim != NULL)
+        return;
+
+    if (hub75_elide_active() && on >= ELIDE_MINOE)
+    {
+        int minRows = (DISPLAY_SCAN * ELIDE_MINOE + on - 1) / on;
+        int n;
+
+        if (minRows < ELIDE_MINROWS)
+            minRows = ELIDE_MINROWS;
+        keep = fbLit | hub75_ticker_rows();     // a lit row is shown while the next shifted row is shifted, black or not
+        n = __builtin_popcount(keep);
+        for (int p = 0; n < minRows; p++)
         {
-            rgb_t* ip_uu = image + (y * DISPLAY_WIDTH);
-            rgb_t* ip_lu = image + ((y + DISPLAY_SCAN) * DISPLAY_WIDTH);
-            rgb_t* ip_ul = image + ((y + DISPLAY_HEIGHT/2) * DISPLAY_WIDTH);
-            rgb_t* ip_ll = image + (((y + DISPLAY_HEIGHT / 2) + DISPLAY_SCAN) * DISPLAY_WIDTH);
-            uint8_t* op_uu = overlay + (y * DISPLAY_WIDTH);
-            uint8_t* op_lu = overlay + ((y + DISPLAY_SCAN) * DISPLAY_WIDTH);
-            uint8_t* op_ul = overlay + ((y + DISPLAY_HEIGHT / 2) * DISPLAY_WIDTH);
-            uint8_t* op_ll = overlay + (((y + DISPLAY_HEIGHT / 2) + DISPLAY_SCAN) * DISPLAY_WIDTH);
-
-            brtCnt = 0;
-            for (x = 0; x < DISPLAY_WIDTH / 2; x++)     // 4 pixels per framebuffer word
+            if (!(keep & (1u << p)))
             {
-                rgb_t ipuu = *ip_uu++;
-                rgb_t iplu = *ip_lu++;
-                rgb_t ipul = *ip_ul++;
-                rgb_t ipll = *ip_ll++;
-
-                if (*op_uu != 0) ipuu = overlayColors[*op_uu];
-                op_uu++;
-                if (*op_lu != 0) iplu = overlayColors[*op_lu];
-                op_lu++;
-                if (*op_ul != 0) ipul = overlayColors[*op_ul];
-                op_ul++;
-                if (*op_ll != 0) ipll = overlayColors[*op_ll];
-                op_ll++;
-
-                rgb_t img = (((ipuu & (1 << b)) >> b) << 2 |
-                        (((ipuu >> 8) & (1 << b)) >> b) << 1 |
-                        ((ipuu >> 16) & (1 << b)) >> b) |
-                    ((((iplu & (1 << b)) >> b) << 2 |
-                        (((iplu >> 8) & (1 << b)) >> b) << 1 |
-                        (((iplu >> 16) & (1 << b))) >> b) << 3) |
-                    ((((ipul & (1 << b)) >> b) << 2 |
-                        (((ipul >> 8) & (1 << b)) >> b) << 1 |
-                        (((ipul >> 16) & (1 << b))) >> b) << 6) |
-                    ((((ipll & (1 << b)) >> b) << 2 |
-                        (((ipll >> 8) & (1 << b)) >> b) << 1 |
-                        (((ipll >> 16) & (1 << b))) >> b) << 9);
-
-                if (++brtCnt > masterBrightness) img |= (1 << 12);
-
-                ipuu = *ip_uu++;
-                iplu = *ip_lu++;
-                ipul = *ip_ul++;
-                ipll = *ip_ll++;
-
-                if (*op_uu != 0) ipuu = overlayColors[*op_uu];
-                op_uu++;
-                if (*op_lu != 0) iplu = overlayColors[*op_lu];
-                op_lu++;
-                if (*op_ul != 0) ipul = overlayColors[*op_ul];
-                op_ul++;
-                if (*op_ll != 0) ipll = overlayColors[*op_ll];
-                op_ll++;
-
-                img |= ((((ipuu & (1 << b)) >> b) << 2 |
-                        (((ipuu >> 8) & (1 << b)) >> b) << 1 |
-                        ((ipuu >> 16) & (1 << b)) >> b) |
-                    ((((iplu & (1 << b)) >> b) << 2 |
-                        (((iplu >> 8) & (1 << b)) >> b) << 1 |
-                        (((iplu >> 16) & (1 << b))) >> b) << 3) |
-                    ((((ipul & (1 << b)) >> b) << 2 |
-                        (((ipul >> 8) & (1 << b)) >> b) << 1 |
-                        (((ipul >> 16) & (1 << b))) >> b) << 6) |
-                    ((((ipll & (1 << b)) >> b) << 2 |
-                        (((ipll >> 8) & (1 << b)) >> b) << 1 |
-                        (((ipll >> 16) & (1 << b))) >> b) << 9)) << 16;
-
-                if (++brtCnt > masterBrightness) img |= (1 << (16+12));
-
-                *fp++ = img;
+                keep |= 1u << p;
+                n++;
             }
+        }
+    }
 
-            uint32_t ctrl = ((y) & 0x1F);                           // ADDR lines: bits 0..4
+    int rows = __builtin_popcount(keep);
+    if (rows != fbOeRows)
+    {
+        uint32_t all[FB_ROW_WORDS], oe[FB_ROW_WORDS];
 
-            *cp++ = ctrl;
+        hub75_oe_row(all, FB_ROW_WORDS, FB_PIXEL_BITS, FB_OE_FLAG, 0);
+        hub75_oe_row(oe, FB_ROW_WORDS, FB_PIXEL_BITS, FB_OE_FLAG, hub75_elide_brightness(rows));
+        for (int i = 0; i < bitPlanes * DISPLAY_SCAN; i++)
+        {
+            uint32_t* w = &frameBuffer[i * FB_ROW_WORDS];
+            for (int x = 0; x < FB_ROW_WORDS; x++)
+                w[x] = (w[x] & ~all[x]) | oe[x];
         }
+        fbOeRows = rows;
     }
+    fbKeep = keep;
+}
 
-    return 0;
+
+
+/*
+ * Precalculate the OE flags of one framebuffer row from the master brightness.
+ * OE is enabled for the first masterBrightness pixels (columns) of a row
+ * The deep colour planes get an OE window of 1/2, 1/4, ... of the normal one. It is rounded to
+ * whole columns, so their precision drops at low brightness.
+ */
+static void hub75_prepare_oe(uint32_t* fb)
+{
+    int brt = masterBrightness;
+
+    if (fb == frameBuffer)      // keep the OE window of the elided rows, hub75_elide_rows() adjusts it
+    {
+        if (!hub75_elide_active())
+            fbOeRows = DISPLAY_SCAN;
+        brt = hub75_elide_brightness(fbOeRows);
+    }
+    hub75_oe_row(oeMask[0], FB_ROW_WORDS, FB_PIXEL_BITS, FB_OE_FLAG, brt);
+    for (int n = 1; n <= shortPlanes; n++)
+        hub75_oe_row(oeMask[n], FB_ROW_WORDS, FB_PIXEL_BITS, FB_OE_FLAG,
+                     hub75_short_brightness(masterBrightness, DISPLAY_WIDTH, n));
+}
+
+
+
+/*
+ * Show a RAM frame from the next BCM cycle on, a running animation is stopped
+ */
+static void hub75_show_frame(uint32_t* fb)
+{
+    if (anim != NULL)
+        hub75_anim_stop();
+    if (fb == frameBuffer)
+        hub75_elide_rows();
+    nextFrame = fb;
+}
+
+
+
+/*
+ * Quantize one image line to bitPlanes bits for temporal dithering phase 'phase'.
+ * A channel is rounded up in as many of the phases as its first frcBits discarded bits count;
+ * a 2x2 ordered pattern shifts the phases from pixel to pixel, so neighbours do not flicker in sync.
+ */
+static void hub75_frc_line(rgb_t* dst, const rgb_t* src, int y, int phase)
+{
+    static const uint8_t bayer[2][2] = { { 0, 2 }, { 3, 1 } };
+    int shift = 8 - bitPlanes;
+    int eShift = shift - frcBits;
+    uint32_t top = 0xFF >> shift;           // max. level with bitPlanes bits
+    uint32_t eMask = frcPhases - 1;
+
+    for (int x = 0; x < DISPLAY_WIDTH; x++)
+    {
+        uint32_t t = (phase + (bayer[y & 1][x & 1] >> (2 - frcBits))) & eMask;
+        rgb_t c = src[x];
+        rgb_t o = 0;
+
+        for (int ch = 0; ch < 24; ch += 8)
+        {
+            uint32_t v = (c >> ch) & 0xFF;
+            uint32_t q = (v >> shift) + ((((v >> eShift) & eMask) > t) ? 1 : 0);
+
+            if (q > top)
+                q = top;
+            o |= (q << shift) << ch;
+        }
+        dst[x] = o;
+    }
+}
+
+
+
+/*
+ * True if the fetched scan row has lit pixels
+ */
+static bool hub75_line_lit(void)
+{
+    rgb_t lit = 0;
+
+    for (int l = 0; l < FB_LINES; l++)
+        for (int x = 0; x < DISPLAY_WIDTH; x++)
+            lit |= lineBuffer[l][x];
+    return (lit & hub75_lit_bits()) != 0;
+}
+
+
+
+/*
+ * Encode the fetched scan row y into frame fb. The live frame is encoded into all temporal dithering phases.
+ */
+static void hub75_store_row(uint32_t* fb, int y, scanLine_t* lo)
+{
+    if (fb == frameBuffer)      // track the lit rows for the row elision
+    {
+        if (y == 0)
+            fbLit = 0;
+        if (hub75_line_lit())
+            fbLit |= 1u << rowPos[y];
+    }
+
+    if (fb != frameBuffer || frcPhases <= 1)
+    {
+        hub75_encode_row(&fb[rowPos[y] * FB_ROW_WORDS], FB_PLANE_WORDS, rowPos[y], lineBuffer, lo);
+        if (fb == frameBuffer)
+            hub75_ticker_row(&fb[rowPos[y] * FB_ROW_WORDS], FB_PLANE_WORDS, y);
+        return;
+    }
+
+    for (int k = 0; k < frcPhases; k++)
+    {
+        for (int l = 0; l < FB_LINES; l++)
+            hub75_frc_line(frcLines[l], lineBuffer[l], y + l * DISPLAY_SCAN, k);
+        hub75_pack_planes(&frcFrame[k][rowPos[y] * FB_ROW_WORDS], FB_PLANE_WORDS, frcLines, 8 - bitPlanes, bitPlanes, oeMask[0]);
+        hub75_ticker_row(&frcFrame[k][rowPos[y] * FB_ROW_WORDS], FB_PLANE_WORDS, y);
+    }
+}
+
+
+
+static void hub75_encode_frame(uint32_t* fb, hub75_row_fn rowFn, void* ctx)
+{
+    hub75_prepare_oe(fb);
+    hub75_ticker_latch();
+
+    for (int y = 0; y < DISPLAY_SCAN; y++)
+    {
+        scanLine_t* lo = hub75_fetch_row(y, rowFn, ctx);
+        hub75_store_row(fb, y, lo);
+    }
+}
+
+
+
+int hub75_update(rgb_t* image, uint8_t* overlay)
+{
+    imageSource_t src = { image, overlay };
+
+    hub75_anim_stop();      // a staged animation streams into frameBuffer
+    hub75_encode_frame(frameBuffer, hub75_image_line, &src);
+    hub75_show_frame(frameBuffer);
+    return 0;
+}
+
+
+
+int hub75_update_generator(hub75_row_fn rowFn, void* ctx)
+{
+    if (rowFn == NULL)
+        return -1;
+
+    hub75_anim_stop();
+    hub75_encode_frame(frameBuffer, rowFn, ctx);
+    hub75_show_frame(frameBuffer);
+    return 0;
+}
+
+
+
+/*
+ * Row generator of hub75_update_mono() for the cases the word encoder does not cover
+ */
+typedef struct monoSource_s {
+    const uint8_t*  bitmap;
+    rgb_t           fg, bg;
+} monoSource_t;
+
+static void hub75_mono_line(int y, rgb_t* line, void* ctx)
+{
+    monoSource_t* src = (monoSource_t*)ctx;
+    const uint8_t* bp = src->bitmap + y * (DISPLAY_WIDTH / 8);
+
+    for (int x = 0; x < DISPLAY_WIDTH; x++)
+        line[x] = (bp[x >> 3] & (0x80 >> (x & 7))) ? src->fg : src->bg;
+}
+
+
+
+int hub75_update_mono(const uint8_t* bitmap, rgb_t fg, rgb_t bg)
+{
+    static uint32_t monoSelect[256];
+    static bool monoInit = false;
+    monoSource_t src = { bitmap, fg, bg };
+    uint32_t on[BCM_PLANES], off[BCM_PLANES];
+
+    if (bitmap == NULL)
+        return -1;
+    if (shortPlanes > 0 || frcPhases > 1 || (ditherMode != HUB75_DITHER_NONE && bitPlanes < 8))
+        return hub75_update_generator(hub75_mono_line, &src);      // per pixel encoding, same result
+
+    if (!monoInit)
+    {
+        hub75_mono_select(monoSelect, FB_COLS, FB_LINES, FB_PIXEL_BITS);
+        monoInit = true;
+    }
+    if (colorActive)
+    {
+        hub75_color_line(&colorLut, &fg, &fg, NULL, 1);
+        hub75_color_line(&colorLut, &bg, &bg, NULL, 1);
+    }
+    uint32_t unit = monoSelect[255] / 7;
+    for (int p = 0; p < bitPlanes; p++)
+    {
+        on[p] = unit * HUB75_PIX_BITS(fg, 8 - bitPlanes + p);
+        off[p] = unit * HUB75_PIX_BITS(bg, 8 - bitPlanes + p);
+    }
+
+    hub75_anim_stop();
+    hub75_prepare_oe(frameBuffer);
+    hub75_ticker_latch();
+    fbLit = 0;
+    for (int y = 0; y < DISPLAY_SCAN; y++)
+    {
+        const uint8_t* lines[FB_LINES];
+        bool lit = (bg & hub75_lit_bits()) != 0;
+
+        for (int l = 0; l < FB_LINES; l++)
+        {
+            lines[l] = bitmap + (y + l * DISPLAY_SCAN) * (DISPLAY_WIDTH / 8);
+            for (int i = 0; !lit && (fg & hub75_lit_bits()) && i < DISPLAY_WIDTH / 8; i++)
+                lit = lines[l][i] != 0;
+        }
+        hub75_mono_row(&frameBuffer[rowPos[y] * FB_ROW_WORDS], FB_PLANE_WORDS, lines, FB_LINES, FB_COLS,
+                       FB_ROW_WORDS, monoSelect, on, off, bitPlanes, oeMask[0]);
+        hub75_ticker_row(&frameBuffer[rowPos[y] * FB_ROW_WORDS], FB_PLANE_WORDS, y);
+        if (lit)
+            fbLit |= 1u << rowPos[y];
+    }
+    hub75_show_frame(frameBuffer);
+    return 0;
+}
+
+
+
+/*
+ * Row generator of hub75_update_indexed() for the cases the palette encoder does not cover
+ */
+typedef struct indexedSource_s {
+    const uint8_t*  image;
+    const rgb_t*    palette;
+    const uint8_t*  overlay;
+} indexedSource_t;
+
+static void hub75_indexed_line(int y, rgb_t* line, void* ctx)
+{
+    indexedSource_t* src = (indexedSource_t*)ctx;
+    const uint8_t* ip = src->image + y * DISPLAY_WIDTH;
+
+    for (int x = 0; x < DISPLAY_WIDTH; x++)
+        line[x] = src->palette[ip[x]];
+    if (src->overlay != NULL)
+        hub75_overlay_line(line, src->overlay + y * HUB75_OVERLAY_STRIDE(DISPLAY_WIDTH, overlayFormat),
+                           DISPLAY_WIDTH, overlayFormat, overlayColors, overlayBlend);
+}
+
+
+
+int hub75_update_indexed(const uint8_t* image, const rgb_t* palette, uint8_t* overlay)
+{
+    static uint32_t entries[256 + 256];     // plane bits of the palette colors and the overlay colors
+    indexedSource_t src = { image, palette, overlay };
+    bool blended = false;
+
+    if (image == NULL || palette == NULL)
+        return -1;
+    for (int i = 1; overlay != NULL && i < 256; i++)
+        blended |= overlayBlend[i] != HUB75_BLEND_REPLACE;
+    if (shortPlanes > 0 || frcPhases > 1 || (ditherMode != HUB75_DITHER_NONE && bitPlanes < 8) || blended)
+        return hub75_update_generator(hub75_indexed_line, &src);   // per pixel encoding, same result
+
+    for (int i = 0; i < (overlay ? 256 + 256 : 256); i++)
+    {
+        rgb_t c = (i < 256) ? palette[i] : overlayColors[i - 256];
+
+        if (colorActive)
+            hub75_color_line(&colorLut, &c, &c, NULL, 1);
+        entries[i] = hub75_palette_entry(c, 8 - bitPlanes, bitPlanes);
+    }
+
+    hub75_anim_stop();
+    hub75_prepare_oe(frameBuffer);
+    hub75_ticker_latch();
+    fbLit = 0;
+    for (int y = 0; y < DISPLAY_SCAN; y++)
+    {
+        uint32_t lit = 0;
+
+        for (int l = 0; l < FB_LINES; l++)      // the line buffer holds the palette entries
+        {
+            int line = y + l * DISPLAY_SCAN;
+            const uint8_t* ip = image + line * DISPLAY_WIDTH;
+            const uint8_t* op = overlay ? overlay + line * HUB75_OVERLAY_STRIDE(DISPLAY_WIDTH, overlayFormat) : NULL;
+            uint32_t* ep = lineBuffer[l];
+
+            for (int x = 0; x < DISPLAY_WIDTH; x++)
+            {
+                int i = (op != NULL) ? hub75_overlay_index(op, x, overlayFormat) : 0;
+
+                ep[x] = entries[(i != 0) ? 256 + i : ip[x]];
+                lit |= ep[x];
+            }
+        }
+        uint32_t* dst = &frameBuffer[rowPos[y] * FB_ROW_WORDS];
+#if HUB75_SIZE == 4040
+        hub75_pack_entries_64(dst, FB_PLANE_WORDS, lineBuffer[0], lineBuffer[1], FB_ROW_WORDS, bitPlanes, oeMask[0]);
+#elif HUB75_SIZE == 8080
+        hub75_pack_entries_128(dst, FB_PLANE_WORDS, lineBuffer[0], lineBuffer[1], lineBuffer[2], lineBuffer[3],
+                               FB_ROW_WORDS, bitPlanes, oeMask[0]);
+#endif
+        hub75_ticker_row(dst, FB_PLANE_WORDS, y);
+        if (lit)
+            fbLit |= 1u << rowPos[y];
+    }
+    hub75_show_frame(frameBuffer);
+    return 0;
+}
+
+
+
+/*
+ * Corrected 16 bit level of panel channel c, interpolated between the 8 bit table entries
+ */
+static uint32_t hub75_color_level16(int c, const rgb48_t* p)
+{
+    uint32_t v = (colorLut.shift[c] == 16) ? p->r : (colorLut.shift[c] == 8) ? p->g : p->b;
+    const uint16_t* lvl = colorLut.level[c];
+    int i = v >> 8;
+    int l0 = lvl[i];
+    int l1 = (i < 255) ? lvl[i + 1] : l0;
+
+    return l0 + (((l1 - l0) * (int)(v & 0xFF)) >> 8);
+}
+
+
+
+/*
+ * Fetch scan row y of a 16 bit per channel image: the upper 8 bits of each channel go to lineBuffer,
+ * the lower ones to lineBufferLo
+ */
+static scanLine_t* hub75_fetch_row48(int y, const rgb48_t* image, const uint8_t* overlay)
+{
+    for (int l = 0; l < FB_LINES; l++)
+    {
+        int line = y + l * DISPLAY_SCAN;
+        const rgb48_t* ip = image + line * DISPLAY_WIDTH;
+        const uint8_t* op = overlay ? overlay + line * HUB75_OVERLAY_STRIDE(DISPLAY_WIDTH, overlayFormat) : NULL;
+        rgb_t* hi = lineBuffer[l];
+        rgb_t* lo = lineBufferLo[l];
+
+        for (int x = 0; x < DISPLAY_WIDTH; x++, ip++)
+        {
+            uint32_t r, g, b;
+            int i = (op != NULL) ? hub75_overlay_index(op, x, overlayFormat) : 0;
+            rgb48_t blended;
+            const rgb48_t* px = ip;
+
+            if (i != 0 && overlayBlend[i] == HUB75_BLEND_REPLACE)
+            {
+                if (colorActive)
+                    hub75_color_line(&colorLut, &overlayColors[i], &hi[x], &lo[x], 1);
+                else
+                    hi[x] = lo[x] = overlayColors[i];       // bit replication of RGB888
+                continue;
+            }
+            if (i != 0)         // blend the overlay color, expanded to 16 bits, onto the image pixel
+            {
+                rgb_t c = overlayColors[i];
+                uint32_t cr = ((c >> 16) & 0xFF) * 257, cg = ((c >> 8) & 0xFF) * 257, cb = (c & 0xFF) * 257;
+
+                if (overlayBlend[i] == HUB75_BLEND_ADD)
+                {
+                    blended.r = (px->r + cr > 0xFFFF) ? 0xFFFF : px->r + cr;
+                    blended.g = (px->g + cg > 0xFFFF) ? 0xFFFF : px->g + cg;
+                    blended.b = (px->b + cb > 0xFFFF) ? 0xFFFF : px->b + cb;
+                }
+                else
+                {
+                    blended.r = (px->r + cr) >> 1;
+                    blended.g = (px->g + cg) >> 1;
+                    blended.b = (px->b + cb) >> 1;
+                }
+                px = &blended;
+            }
+            if (colorActive)
+            {
+                r = hub75_color_level16(0, px);
+                g = hub75_color_level16(1, px);
+                b = hub75_color_level16(2, px);
+            }
+            else
+            {
+                r = px->r;
+                g = px->g;
+                b = px->b;
+            }
+            hi[x] = ((r >> 8) << 16) | (g & 0xFF00) | (b >> 8);
+            lo[x] = ((r & 0xFF) << 16) | ((g & 0xFF) << 8) | (b & 0xFF);
+        }
+    }
+    hub75_dither_row(y);
+    return lineBufferLo;
+}
+
+
+
+int hub75_update_deep(const rgb48_t* image, uint8_t* overlay)
+{
+    hub75_anim_stop();
+    hub75_prepare_oe(frameBuffer);
+    hub75_ticker_latch();
+
+    for (int y = 0; y < DISPLAY_SCAN; y++)
+    {
+        scanLine_t* lo = hub75_fetch_row48(y, image, overlay);
+        hub75_store_row(frameBuffer, y, lo);
+    }
+    hub75_show_frame(frameBuffer);
+    return 0;
+}
+
+
+
+/*
+ * Framebuffer row position currently fed to the data state machine by the display DMA channel
+ */
+static int hub75_beam_row(void)
+{
+    uint32_t remaining = dma_hw->ch[display_dma_chan].transfer_count;
+    int row = (FB_PLANE_WORDS - remaining) / FB_ROW_WORDS;
+
+    return (row >= DISPLAY_SCAN) ? 0 : row;
+}
+
+
+
+int hub75_update_stream(rgb_t* image, uint8_t* overlay)
+{
+    imageSource_t src = { image, overlay };
+    static uint32_t bandBuffer[DISPLAY_MAXPLANES * HUB75_STREAM_BAND * FB_ROW_WORDS];
+    const int bandWords = HUB75_STREAM_BAND * FB_ROW_WORDS;
+
+    if (frcPhases > 1 || (ditherMode == HUB75_DITHER_FS && bitPlanes < 8) || hub75_elide_active() || rowMapNext != NULL)
+        return hub75_update(image, overlay);    // phase frames are rotated as a whole, error diffusion needs top down order,
+                                                // elided rows are selected for the complete frame, the beam position
+                                                // is not known with row map runs
+    uint32_t lit = 0;
+
+    hub75_anim_stop();
+    hub75_prepare_oe(frameBuffer);
+    hub75_ticker_latch();
+
+    // start with the band the beam has just left, so it has the longest time until the beam returns
+    int first = (hub75_beam_row() / HUB75_STREAM_BAND) * HUB75_STREAM_BAND;
+    first = (first + DISPLAY_SCAN - HUB75_STREAM_BAND) % DISPLAY_SCAN;
+
+    for (int n = 0; n < DISPLAY_SCAN; n += HUB75_STREAM_BAND)
+    {
+        int y0 = (first + n) % DISPLAY_SCAN;    // bands are runs of framebuffer row positions
+
+        for (int y = y0; y < y0 + HUB75_STREAM_BAND; y++)
+        {
+            scanLine_t* lo = hub75_fetch_row(rowAt[y], hub75_image_line, &src);
+            if (hub75_line_lit())
+                lit |= 1u << y;
+            hub75_encode_row(&bandBuffer[(y - y0) * FB_ROW_WORDS], bandWords, y, lineBuffer, lo);
+            hub75_ticker_row(&bandBuffer[(y - y0) * FB_ROW_WORDS], bandWords, rowAt[y]);
+        }
+
+        // publish the band while the beam is outside of it, so no plane shows a half updated row
+        uint32_t t0 = time_us_32();
+        int row = hub75_beam_row();
+        while (row >= y0 && row < y0 + HUB75_STREAM_BAND && (time_us_32() - t0) < HUB75_STREAM_TIMEOUT)
+            row = hub75_beam_row();
+
+        for (int p = 0; p < bitPlanes; p++)
+            memcpy(&frameBuffer[p * FB_PLANE_WORDS + y0 * FB_ROW_WORDS], &bandBuffer[p * bandWords], bandWords * sizeof(uint32_t));
+    }
+    fbLit = lit;                // for a later hub75_set_elision()
+    hub75_show_frame(frameBuffer);
+
+    return 0;
+}
+
+
+
+// -- ticker -----------------------------------------------------------------
+
+/*
+ * Called by the display DMA interrupt at the end of each BCM cycle
+ */
+static void hub75_ticker_advance(void)
+{
+    int32_t pos = tickerPos + tickerSpeed;
+    int32_t width = tickerWidth << 16;
+
+    if (pos >= width)
+        pos -= width;
+    else if (pos < 0)
+        pos += width;
+    tickerPos = pos;
+}
+
+
+
+int hub75_ticker_setup(uint32_t* strip, const rgb_t* image, int width, int height, int top)
+{
+    int chunks = (width + DISPLAY_WIDTH - 1) / DISPLAY_WIDTH;
+
+    if (strip == NULL || image == NULL || width < 1 || width > 32767 - FB_COLS || width % HUB75_TICKER_ALIGN != 0 ||
+        height < 1 || top < 0 || top + height > DISPLAY_HEIGHT)
+        return -1;      // the wrap around is a word boundary of the strip
+
+    tickerStrip = NULL;         // the display keeps the former position until the new strip is published
+    tickerStride = chunks * FB_ROW_WORDS;
+    for (int i = 0; i < height; i++)
+    {
+        int l = (top + i) / DISPLAY_SCAN;
+
+        for (int c = 0; c < chunks; c++)
+        {
+            scanLine_t* lo = tickerLines;
+
+            memset(tickerLines, 0, sizeof(tickerLines));
+            for (int x = 0; x < DISPLAY_WIDTH && c * DISPLAY_WIDTH + x < width; x++)
+                tickerLines[l][x] = image[i * width + c * DISPLAY_WIDTH + x];
+            if (colorActive)
+            {
+                hub75_color_line(&colorLut, tickerLines[l], tickerLines[l], shortPlanes ? tickerLinesLo[l] : NULL, DISPLAY_WIDTH);
+                lo = tickerLinesLo;
+            }
+            hub75_encode_row(&strip[i * bitPlanes * tickerStride + c * FB_ROW_WORDS], tickerStride, 1, tickerLines, lo);
+        }
+    }
+
+    tickerTop = top;
+    tickerHeight = height;
+    tickerWidth = width;
+    tickerPlanes = bitPlanes;
+    tickerSpeed = 0;
+    tickerPos = 0;
+    tickerStrip = strip;
+    return 0;
+}
+
+
+
+void hub75_ticker_scroll(int32_t pos, int32_t speed)
+{
+    int32_t width = tickerWidth << 16;
+
+    if (tickerStrip == NULL)
+        return;
+    pos %= width;
+    tickerPos = (pos < 0) ? pos + width : pos;
+    tickerSpeed = speed;
+}
+
+
+
+int32_t hub75_ticker_pos(void)
+{
+    return tickerPos;
+}
+
+
+
+void hub75_ticker_refresh(void)
+{
+    if (tickerStrip != NULL)
+        hub75_anim_stop();
+    hub75_ticker_latch();
+    for (int i = 0; tickerStrip != NULL && i < tickerHeight; i++)
+    {
+        int y = (tickerTop + i) % DISPLAY_SCAN;
+
+        if (frcPhases > 1)
+        {
+            for (int k = 0; k < frcPhases; k++)
+                hub75_ticker_row(&frcFrame[k][rowPos[y] * FB_ROW_WORDS], FB_PLANE_WORDS, y);
+        }
+        else
+            hub75_ticker_row(&frameBuffer[rowPos[y] * FB_ROW_WORDS], FB_PLANE_WORDS, y);
+    }
+}
+
+
+
+void hub75_ticker_stop(void)
+{
+    tickerStrip = NULL;
+    tickerSpeed = 0;
+}
+
+
+
+// -- row map ----------------------------------------------------------------
+
+int hub75_set_rowmap(const uint8_t* map)
+{
+    uint8_t* m = NULL;
+
+    if (map != NULL)
+    {
+        bool identity = true;
+
+        for (int y = 0; y < DISPLAY_SCAN; y++)
+        {
+            if (map[y] >= DISPLAY_SCAN)
+                return -1;
+            identity &= (map[y] == y);
+        }
+        if (!identity && shortPlanes > 0)
+            return -1;                  // row 0 of each plane carries the OE flags of the plane shown before it
+        if (!identity)
+        {
+            m = (rowMap == rowMaps[0]) ? rowMaps[1] : rowMaps[0];    // never the map the DMA runs are built from
+            memcpy(m, map, DISPLAY_SCAN);
+        }
+    }
+    if (m == NULL && rowMapNext == NULL)
+        return 0;
+
+    rowMapNext = m;
+    rowMapPending = true;
+    return 0;
+}
+
+
+
+int hub75_set_vscroll(int rows)
+{
+    uint8_t map[DISPLAY_SCAN];
+
+    rows %= DISPLAY_SCAN;
+    if (rows < 0)
+        rows += DISPLAY_SCAN;
+    for (int y = 0; y < DISPLAY_SCAN; y++)
+        map[y] = (y + rows) % DISPLAY_SCAN;
+    return hub75_set_rowmap(map);
+}
+
+
+
+// -- frame cache ------------------------------------------------------------
+
+typedef struct cacheSlot_s {
+    uint32_t    key;
+    uint32_t    lastUse;        // LRU stamp, 0 = slot is free
+    uint32_t*   frame;
+} cacheSlot_t;
+
+#define CACHE_POOL_WORDS    (HUB75_CACHE_SIZE / sizeof(uint32_t))
+static uint32_t     cachePool[CACHE_POOL_WORDS > 0 ? CACHE_POOL_WORDS : 1];  // no frame fits with HUB75_CACHE_SIZE 0
+static cacheSlot_t  cacheSlots[HUB75_CACHE_SLOTS];
+static int          cacheSlotCnt = 0;       // slots fitting into the pool with the current number of planes
+static uint32_t     cacheStamp = 0;
+
+
+void hub75_cache_clear(void)
+{
+    int frameWords = bitPlanes * FB_PLANE_WORDS;
+
+    // the start of the pool may hold temporal dithering phase frames
+    cacheSlotCnt = (CACHE_POOL_WORDS - frcPoolWords) / frameWords;
+    if (cacheSlotCnt > HUB75_CACHE_SLOTS)
+        cacheSlotCnt = HUB75_CACHE_SLOTS;
+
+    for (int i = 0; i < cacheSlotCnt; i++)
+    {
+        cacheSlots[i].lastUse = 0;
+        cacheSlots[i].frame = &cachePool[frcPoolWords + i * frameWords];
+    }
+}
+
+
+
+// -- temporal dithering ------------------------------------------------------
+
+/*
+ * Assign the phase frames for the current number of planes: the unused part of frameBuffer first,
+ * then the start of the frame cache pool
+ */
+static void hub75_frc_setup(void)
+{
+    int frameWords = bitPlanes * FB_PLANE_WORDS;
+    int inFb = DISPLAY_MAXPLANES / bitPlanes;
+    int inPool = CACHE_POOL_WORDS / frameWords;
+    int bits = 0;
+    int n = 0;
+
+    frcPhases = 0;                  // the display interrupt stops rotating
+    frcPhase = 0;
+    frcPoolWords = 0;
+
+    if (frcRequest > 1 && bitPlanes < 8)
+    {
+        bits = (frcRequest >= 4 && inFb + inPool >= 4) ? 2 : (inFb + inPool >= 2) ? 1 : 0;
+        if (bits > 8 - bitPlanes)
+            bits = 8 - bitPlanes;
+    }
+
+    for (; n < (1 << bits) && n < inFb; n++)
+        frcFrame[n] = &frameBuffer[n * frameWords];
+    for (; n < (1 << bits); n++)
+    {
+        frcFrame[n] = &cachePool[frcPoolWords];
+        memset(frcFrame[n], 0, frameWords * sizeof(uint32_t));
+        frcPoolWords += frameWords;
+    }
+    hub75_cache_clear();
+
+    frcBits = bits;
+    frcPhases = bits ? (1 << bits) : 0;
+}
+
+
+
+int hub75_set_frc(int phases)
+{
+    if (phases != 0 && phases != 2 && phases != 4)
+        return -1;
+
+    hub75_anim_stop();
+    frcRequest = phases;
+    nextFrame = frameBuffer;
+    hub75_frc_setup();              // drops the cached frames, the pool may be used for phases
+    return frcPhases;
+}
+
+
+
+static cacheSlot_t* hub75_cache_find(uint32_t key)
+{
+    for (int i = 0; i < cacheSlotCnt; i++)
+    {
+        if (cacheSlots[i].lastUse != 0 && cacheSlots[i].key == key)
+            return &cacheSlots[i];
+    }
+    return NULL;
+}
+
+
+
+/*
+ * Slot for a new frame: the slot of key, a free slot or the least recently used one, never the frame on screen
+ */
+static cacheSlot_t* hub75_cache_alloc(uint32_t key)
+{
+    cacheSlot_t* slot = hub75_cache_find(key);
+
+    if (slot == NULL)
+    {
+        // take a free slot or evict the least recently used one, but never the frame on screen
+        for (int i = 0; i < cacheSlotCnt; i++)
+        {
+            cacheSlot_t* s = &cacheSlots[i];
+
+            if (s->frame == displayFrame || s->frame == nextFrame)
+                continue;
+            if (slot == NULL || s->lastUse < slot->lastUse)
+                slot = s;
+        }
+    }
+    else if (slot->frame == displayFrame || slot->frame == nextFrame)
+        return NULL;                        // do not overwrite the frame on screen
+
+    if (slot != NULL)
+        slot->lastUse = 0;
+    return slot;
+}
+
+
+
+int hub75_cache_store(uint32_t key, rgb_t* image, uint8_t* overlay)
+{
+    imageSource_t src = { image, overlay };
+    cacheSlot_t* slot = hub75_cache_alloc(key);
+
+    if (slot == NULL)
+        return -1;
+
+    hub75_encode_frame(slot->frame, hub75_image_line, &src);
+    slot->key = key;
+    slot->lastUse = ++cacheStamp;
+
+    return 0;
+}
+
+
+
+int hub75_cache_store_anim(uint32_t key, const hub75_anim_t* a, int frame)
+{
+    if (a == NULL || a->magic != HUB75_ANIM_MAGIC || a->width != DISPLAY_WIDTH || a->height != DISPLAY_HEIGHT ||
+        a->planes != bitPlanes || a->frameWords != bitPlanes * FB_PLANE_WORDS || HUB75_ANIM_ROWS(a->flags) != rowOrder ||
+        frame < 0 || frame >= a->frameCount)
+        return -1;
+
+    cacheSlot_t* slot = hub75_cache_alloc(key);
+    if (slot == NULL)
+        return -1;
+
+    if (a->flags & HUB75_ANIM_FMT_RLE)
+    {
+        if (hub75_rle_decode(&a->frames[a->offsets[frame]], slot->frame, a->frameWords) < 0)
+            return -1;
+    }
+    else
+        memcpy(slot->frame, &a->frames[frame * a->frameWords], a->frameWords * sizeof(uint32_t));
+
+    slot->key = key;
+    slot->lastUse = ++cacheStamp;
+    return 0;
+}
+
+
+
+int hub75_cache_show(uint32_t key)
+{
+    cacheSlot_t* slot = hub75_cache_find(key);
+
+    if (slot == NULL)
+        return -1;
+
+    slot->lastUse = ++cacheStamp;
+    hub75_show_frame(slot->frame);
+    return 0;
+}
+
+
+
+void hub75_cache_drop(uint32_t key)
+{
+    cacheSlot_t* slot = hub75_cache_find(key);
+
+    if (slot != NULL && slot->frame != displayFrame && slot->frame != nextFrame)
+        slot->lastUse = 0;
+}
+
+
+
+// -- animations from flash ---------------------------------------------------
+
+#define XIP_WINDOW_END  (XIP_NOCACHE_NOALLOC_BASE + 0x01000000)     // end of the 4 aliases of the 16 MB flash window
+
+
+/*
+ * Start reading one frame of the animation through the XIP streaming FIFO into a RAM buffer
+ */
+static void hub75_anim_stage(int frame, uint32_t* dst)
+{
+    while (!(xip_ctrl_hw->stat & XIP_STAT_FIFO_EMPTY))
+        (void) xip_ctrl_hw->stream_fifo;
+    xip_ctrl_hw->stream_addr = (uint32_t)&anim->frames[frame * anim->frameWords];
+    xip_ctrl_hw->stream_ctr = anim->frameWords;
+
+    dma_channel_set_write_addr(animStageChan, dst, false);
+    dma_channel_set_trans_count(animStageChan, anim->frameWords, false);
+    dma_channel_set_read_addr(animStageChan, (const void*)XIP_AUX_BASE, true);
+}
+
+
+
+/*
+ * Called by the display DMA interrupt at the end of each BCM cycle
+ */
+static void hub75_anim_tick(void)
+{
+    if (++animTicks < anim->frameTicks)
+        return;
+
+    int next = animFrame + 1;
+    if (next >= anim->frameCount)
+    {
+        if (!(animFlags & HUB75_ANIM_LOOP))
+            return;                 // keep the last frame
+        next = 0;
+    }
+
+    if (animFlags & HUB75_ANIM_STAGED)
+    {
+        if (dma_channel_is_busy(animStageChan))
+            return;                 // flash is too slow, show the current frame one more cycle
+        nextFrame = animStage[animStageIdx];
+        animStageIdx ^= 1;
+        // the old buffer is still read during the last BCM step (MSB plane at its end),
+        // staging from flash reaches that part long after the step is done
+        hub75_anim_stage((next + 1) % anim->frameCount, animStage[animStageIdx]);
+    }
+    else
+        nextFrame = (uint32_t*)&anim->frames[next * anim->frameWords];
+
+    animFrame = next;
+    animTicks = 0;
+}
+
+
+
+int hub75_anim_play(const hub75_anim_t* a, int flags)
+{
+    if (a == NULL || a->magic != HUB75_ANIM_MAGIC || a->width != DISPLAY_WIDTH || a->height != DISPLAY_HEIGHT ||
+        a->planes != bitPlanes || a->frameWords != bitPlanes * FB_PLANE_WORDS || HUB75_ANIM_ROWS(a->flags) != rowOrder ||
+        a->frameCount == 0 ||
+        (a->flags & HUB75_ANIM_FMT_RLE))
+        return -1;
+
+    hub75_anim_stop();
+
+    if (flags & HUB75_ANIM_STAGED)
+    {
+        uintptr_t start = (uintptr_t)a->frames;
+        uintptr_t end = start + (uintptr_t)a->frameCount * a->frameWords * sizeof(uint32_t);
+
+        // the frame cache pool is used as second RAM buffer, the phase frames of temporal dithering
+        // are kept in frameBuffer and the pool, the stream FIFO only reads from flash
+        if (CACHE_POOL_WORDS < a->frameWords || frcPhases > 1 || start < XIP_BASE || end > XIP_WINDOW_END)
+            return -1;
+        animStageChan = dma_claim_unused_channel(false);
+        if (animStageChan < 0)
+            return -1;
+        cacheSlotCnt = 0;
+
+        dma_channel_config c = dma_channel_get_default_config(animStageChan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, false);
+        channel_config_set_write_increment(&c, true);
+        channel_config_set_dreq(&c, DREQ_XIP_STREAM);
+        dma_channel_set_config(animStageChan, &c, false);
+
+        // the frames bring their own OE flags and all rows: shift out all of frameBuffer from now on
+        fbLit = fbKeep = ROWS_ALL;
+        fbOeRows = DISPLAY_SCAN;
+        animStage[0] = frameBuffer;
+        animStage[1] = cachePool;
+    }
+
+    animFlags = flags;
+    animFrame = 0;
+    animTicks = 0;
+    anim = a;
+
+    if (flags & HUB75_ANIM_STAGED)
+    {
+        hub75_anim_stage(0, animStage[0]);
+        dma_channel_wait_for_finish_blocking(animStageChan);
+        nextFrame = animStage[0];
+        animStageIdx = 1;
+        hub75_anim_stage(1 % a->frameCount, animStage[1]);
+    }
+    else
+        nextFrame = (uint32_t*)a->frames;
+
+    return 0;
+}
+
+
+
+void hub75_anim_stop(void)
+{
+    if (anim == NULL)
+        return;
+
+    anim = NULL;
+    if (animStageChan >= 0)
+    {
+        dma_channel_abort(animStageChan);
+        dma_channel_unclaim(animStageChan);
+        animStageChan = -1;
+        nextFrame = frameBuffer;
+        hub75_cache_clear();        // pool was used as staging buffer
+    }
+}
+
+
+
+bool hub75_anim_running(void)
+{
+    return anim != NULL;
 }
-#endif
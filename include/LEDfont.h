@@ -0,0 +1,65 @@
+/*****************************************************
+ *
+ *	LED matrix driver for Raspberry RP2040
+ *	(c) Peter Schulten, Mülheim, Germany
+ *	peter_(at)_pitschu.de
+ *
+ *  Unmodified reproduction and distribution of this entire
+ *  source code in any form is permitted provided the above
+ *  notice is preserved.
+ *  I make this source code available free of charge and therefore
+ *  offer neither support nor guarantee for its functionality.
+ *  Furthermore, I assume no liability for the consequences of
+ *  its use.
+ *  The source code may only be used and modified for private,
+ *  non-commercial purposes. Any further use requires my consent.
+ *
+ *	History
+ *	25.01.2022	pitschu		Start of work
+ */
+#ifndef LEDFONT__H_
+#define LEDFONT__H_
+
+#include "LEDmx.h"
+
+// Glyph cache, see LEDfont_DrawText()
+#ifndef LEDFONT_CACHE_SIZE
+#define LEDFONT_CACHE_SIZE      8192        // bytes of glyph spans (build option)
+#endif
+#ifndef LEDFONT_CACHE_SLOTS
+#define LEDFONT_CACHE_SLOTS     128         // cached glyphs, power of 2 (build option)
+#endif
+
+typedef struct ledfontGlyph_s {
+    uint32_t        code;               // Unicode code point, glyphs are sorted by it
+    uint16_t        offset;             // first byte of the bitmap in font->bitmaps
+    uint8_t         w, h;               // bitmap size, lines of (w * bpp + 7) / 8 bytes
+    int8_t          dx;                 // left edge of the bitmap from the pen position
+    int8_t          dy;                 // top edge of the bitmap from the top of the text line
+    uint8_t         advance;            // pen step to the next glyph
+} ledfontGlyph_t;
+
+typedef struct ledfontKern_s {
+    uint16_t        left, right;        // code points of the pair, sorted by left, then right
+    int8_t          dx;                 // added to the advance of left
+} ledfontKern_t;
+
+typedef struct ledfont_s {
+    uint8_t         bpp;                // 1 (MSB first) or 4 (coverage 0..15, even pixel in the low nibble)
+    uint8_t         height;             // line height
+    uint8_t         ascent;             // baseline from the top of the line
+    uint16_t        glyphCount;
+    uint16_t        kernCount;
+    const ledfontGlyph_t* glyphs;
+    const ledfontKern_t*  kerning;
+    const uint8_t*  bitmaps;
+} ledfont_t;
+
+uint32_t LEDfont_NextChar(const char** text);
+int  LEDfont_DrawText(const ledfont_t* font, int16_t x, int16_t y, const char* text, rgb_t color, bool overlay);
+int  LEDfont_RenderText(const ledfont_t* font, rgb_t* image, int width, int height, int16_t x, int16_t y,
+                       const char* text, rgb_t color);
+int  LEDfont_TextWidth(const ledfont_t* font, const char* text);
+void LEDfont_ClearCache(void);
+
+#endif
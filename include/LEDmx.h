@@ -34,9 +34,10 @@ extern uint16_t    bitPlanes;
 #define 	MAP_888_to_565(c)			(uint16_t)(((c >> 8) & 0xF8) | ((c >> 5) & 0x7E) | ((c >> 3) & 0x1F))
 #define 	MAP_565_to_888(c)			(rgb_t)((((rgb_t)(c) & 0xf800) << 8) | ((c & 0x03E0) << 5) | ((c & 0x1f) << 3))
 
-#define 	MAP_888_R_TO_PWM(r)			((((uint32_t)(r) >> 16) & 0xff) >> (8-bitPlanes))
-#define 	MAP_888_G_TO_PWM(g)			((((uint32_t)(g) >> 8 ) & 0xff) >> (8-bitPlanes))
-#define 	MAP_888_B_TO_PWM(b)			((((uint32_t)(b)      ) & 0xff) >> (8-bitPlanes))
+#define 	MAP_888_PWM_SHIFT			(bitPlanes < 8 ? 8 - bitPlanes : 0)	// deep colour planes add no bits to RGB888
+#define 	MAP_888_R_TO_PWM(r)			((((uint32_t)(r) >> 16) & 0xff) >> MAP_888_PWM_SHIFT)
+#define 	MAP_888_G_TO_PWM(g)			((((uint32_t)(g) >> 8 ) & 0xff) >> MAP_888_PWM_SHIFT)
+#define 	MAP_888_B_TO_PWM(b)			((((uint32_t)(b)      ) & 0xff) >> MAP_888_PWM_SHIFT)
 
 #define 	MAP_888_R(r)			((((uint32_t)(r) >> 16) & 0xff))
 #define 	MAP_888_G(g)			((((uint32_t)(g) >> 8 ) & 0xff))
@@ -88,24 +89,130 @@ extern uint32_t display_buffers[DISPLAY_FRAMEBUFFER_SIZE];
 extern uint32_t* display_front_buf;
 extern uint32_t* display_back_buf;
 
-extern uint8_t  overlayBuffer[DISPLAY_FRAMEBUFFER_SIZE];
+// LEDMX_OVERLAY_NIBBLE (build option) stores the overlay with 4 bits per pixel, 15 colors
+#ifdef LEDMX_OVERLAY_NIBBLE
+#ifndef HUB75_BCM
+#error "LEDMX_OVERLAY_NIBBLE needs the BCM driver"
+#endif
+#define LEDMX_OVERLAY_SIZE  (DISPLAY_FRAMEBUFFER_SIZE / 2)
+#else
+#define LEDMX_OVERLAY_SIZE  DISPLAY_FRAMEBUFFER_SIZE
+#endif
+
+extern uint8_t  overlayBuffer[LEDMX_OVERLAY_SIZE];
+
+// Compositor layers, see LEDmx_LayerSetup()
+#ifndef LEDMX_LAYERS
+#define LEDMX_LAYERS        4           // number of layers (build option)
+#endif
+#define LEDMX_SPAN          8           // pixels per occupancy bit, layers are max. 16 spans wide
+
+#define LEDMX_LAYER_OFF     0
+#define LEDMX_LAYER_RGB     1           // rgb_t per pixel, opaque in the occupied spans
+#define LEDMX_LAYER_INDEXED 2           // one byte per pixel, index 0 transparent
+#define LEDMX_LAYER_NIBBLE  3           // 4 bits per pixel (even pixel in the low nibble), index 0 transparent
+
+// Tilemap entries, see LEDmx_TilemapSetup()
+#define LEDMX_TILE          8           // tiles are 8x8 pixels
+#define LEDMX_TILE_INDEX    0x03FF      // bits 0..9: tile number
+#define LEDMX_TILE_PAL(n)   ((n) << 10) // bits 10..13: palette (16 colors each)
+#define LEDMX_TILE_FLIPX    (1 << 14)   // mirror left / right
+#define LEDMX_TILE_FLIPY    (1 << 15)   // mirror top / bottom
+
+// Bitmap formats, see LEDmx_Blit()
+#define LEDMX_BMP_RGB888    0           // rgb_t per pixel, bits 24..31 zero like the canvas
+#define LEDMX_BMP_RGB565    1           // uint16_t per pixel
+#define LEDMX_BMP_INDEX1    2           // 1 bit per pixel, MSB first = leftmost pixel
+#define LEDMX_BMP_INDEX4    3           // 4 bits per pixel, even pixel in the low nibble
+#define LEDMX_BMP_INDEX8    4           // one byte per pixel
+
+#define LEDMX_BLIT_KEY      (1 << 0)    // source pixels equal to bmp->key are transparent
+#define LEDMX_BLIT_FLIPX    (1 << 1)    // mirror left / right
+#define LEDMX_BLIT_FLIPY    (1 << 2)    // mirror top / bottom
+#define LEDMX_BLIT_OVERLAY  (1 << 3)    // draw indexed bitmaps into the overlay instead of the canvas
+#define LEDMX_BLIT_BILINEAR (1 << 4)    // LEDmx_BlitAffine(): filter between the 4 nearest pixels (canvas only)
+
+typedef struct ledmxBitmap_s {
+    uint8_t         format;             // LEDMX_BMP_xxx
+    int16_t         w, h;
+    int16_t         stride;             // bytes per line
+    const void*     pixels;
+    const rgb_t*    palette;            // colors of the indexed formats on the canvas
+    uint32_t        key;                // transparent index or RGB888 color (MAP_565_to_888() of it for RGB565)
+} ledmxBitmap_t;
+
+#ifndef LEDMX_CLIP_DEPTH
+#define LEDMX_CLIP_DEPTH    8           // nesting of LEDmx_PushClip() (build option)
+#endif
+
+typedef void (*LEDmx_dma_fn)(void* ctx);   // completion of LEDmx_FillDMA() / LEDmx_BlitDMA(), called from the DMA interrupt
 
 void LEDmx_getFlushSemaphore(void);
 void LEDmx_putFlushSemaphore(void);
 
 void LEDmx_start();
+
+#ifdef HUB75_BCM                        // BCM driver only, not available with the PWM driver (hub75.c)
+void LEDmx_SetLowLatency(bool on);
+void LEDmx_SetGenerator(hub75_row_fn rowFn, void* ctx);
+int  LEDmx_StoreScreen(uint32_t key);
+int  LEDmx_ShowScreen(uint32_t key);
+int  LEDmx_PlayAnimation(const hub75_anim_t* anim, int flags);
+void LEDmx_ShowCanvas(void);
+int  LEDmx_Ticker(uint32_t* strip, const rgb_t* image, int width, int height, int top, int32_t speed);
+void LEDmx_TickerStop(void);
+void LEDmx_SetIndexedMode(bool on);
+void LEDmx_SetIndexPixel(int x, int y, uint8_t index);
+void LEDmx_ClearIndexed(uint8_t index);
+void LEDmx_SetPalette(int first, int count, const rgb_t* colors);
+void LEDmx_RotatePalette(int first, int count, int step);
+
+int  LEDmx_LayerSetup(int layer, int format, int w, int h, void* pixels, uint16_t* occupancy);
+void LEDmx_LayerSetColors(int layer, const rgb_t* colors, const uint8_t* blend);
+void LEDmx_LayerMove(int layer, int x, int y);
+void LEDmx_LayerShow(int layer, bool visible);
+void LEDmx_LayerSetZ(int layer, int z);
+void LEDmx_LayerSetPixel(int layer, int x, int y, uint32_t value);
+void LEDmx_LayerMark(int layer, int x, int y, int w, int h);
+void LEDmx_LayerClear(int layer);
+void LEDmx_UseLayers(bool on, rgb_t bg);
+int  LEDmx_TilemapSetup(const uint32_t* tiles, int tileCount, uint16_t* map, int mapW, int mapH, const rgb_t* colors);
+void LEDmx_TilemapScroll(int x, int y);
+void LEDmx_TilemapSet(int tx, int ty, uint16_t entry);
+void LEDmx_UseTilemap(bool on);
+#endif
+
 void LEDmx_SetMasterBrightness(int brt);
 
 void LEDmx_SetPixel(int x, int y, rgb_t color);
 void LEDmx_SetPixelRGB(int x, int y, uint8_t R, uint8_t G, uint8_t B);
 void LEDmx_DrawPixel(int16_t x, int16_t y, rgb_t color);
 void LEDmx_Rect(int16_t l, int16_t t, int16_t r, int16_t b, rgb_t color, bool overlay);
+void LEDmx_HLine(int16_t x1, int16_t x2, int16_t y, rgb_t color, bool overlay);
+void LEDmx_HLineAlpha(int16_t x1, int16_t x2, int16_t y, rgb_t color, uint8_t alpha);
+void LEDmx_VLine(int16_t x, int16_t y1, int16_t y2, rgb_t color, bool overlay);
+void LEDmx_FillSpan32(uint32_t* dst, uint32_t value, int count);
 void LEDmx_setAlphaRGB(uint8_t r, uint8_t g, uint8_t b);
 void LEDmx_setAlpha(rgb_t color);
 void LEDmx_setAlphaDisabled(void);
+void LEDmx_SetDrawAlpha(uint8_t alpha);
+void LEDmx_Blit(int16_t x, int16_t y, const ledmxBitmap_t* bmp, int flags);
+void LEDmx_BlitAffine(const ledmxBitmap_t* bmp, const int32_t m[6], int flags);
+int  LEDmx_AffineRotate(int32_t m[6], uint16_t angle, int32_t scale, int16_t dx, int16_t dy, int16_t sx, int16_t sy);
+int32_t LEDmx_Sin(uint16_t angle);
+void LEDmx_BlitAlpha(int16_t x, int16_t y, const uint32_t* src, int w, int h, int srcStride, bool premultiplied);
 void LEDmx_ClearScreen(rgb_t color);
+void LEDmx_Invalidate(void);
+int  LEDmx_FillDMA(int16_t l, int16_t t, int16_t r, int16_t b, rgb_t color, LEDmx_dma_fn done, void* ctx);
+int  LEDmx_BlitDMA(int16_t x, int16_t y, const uint32_t* src, int w, int h, int srcStride, LEDmx_dma_fn done, void* ctx);
+bool LEDmx_DMABusy(void);
+void LEDmx_DMAWait(void);
 void LEDmx_BlankScreen(void);
 void LEDmx_SetClip(int16_t l, int16_t r, int16_t t, int16_t b);
+int  LEDmx_PushClip(int16_t l, int16_t r, int16_t t, int16_t b);
+void LEDmx_PopClip(void);
+void LEDmx_ResetClip(void);
+void LEDmx_GetClip(int16_t* l, int16_t* r, int16_t* t, int16_t* b);
 uint8_t LEDmx_IsClipped(int16_t x, int16_t y);
 
 void LEDmx_DrawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2, rgb_t color, bool overlay);
@@ -113,6 +220,9 @@ void LEDmx_DrawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2, rgb_t color,
 void LEDmx_ClearOverlay (void);
 void LEDmx_SetOverlayPixel(int x, int y, int color);
 void LEDmx_SetOverlayColor(int index, rgb_t color);
+#ifdef HUB75_BCM
+void LEDmx_SetOverlayBlend(int index, int mode);
+#endif
 
 uint32_t LEDmx_565toRGB(uint16_t pix);
 #endif
\ No newline at end of file
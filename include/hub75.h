@@ -27,11 +27,18 @@
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
 #include "hardware/dma.h"
+#include "hub75_encode.h"
 
 
-// Integer between 1 and 8
-// Lower numbers cause LSBs to be skipped
-#define DISPLAY_MAXPLANES 8
+// Integer between 1 and 8 (PWM version), up to 12 in the BCM version
+// Lower numbers cause LSBs to be skipped, planes above 8 are shown with a shortened OE pulse (deep colour)
+#ifndef DISPLAY_MAXPLANES
+#if defined(HUB75_BCM) && HUB75_SIZE == 4040
+#define DISPLAY_MAXPLANES 12
+#else
+#define DISPLAY_MAXPLANES 8            // 128x128 BCM: 8 KB framebuffer per extra plane, set 10..12 as build variable
+#endif
+#endif
 
 extern uint16_t    bitPlanes;
 
@@ -207,7 +214,37 @@ typedef struct rgbValue_s {
     uint8_t		B;
 } rgbValue_t;
 
-typedef uint32_t	rgb_t;
+
+// Pre-encoded animation, frames in framebuffer format (usually const data in XIP flash)
+#define HUB75_ANIM_MAGIC    0x35374248      // "HB75"
+
+typedef struct hub75_anim_s {
+    uint32_t        magic;          // HUB75_ANIM_MAGIC
+    uint16_t        width;          // must match DISPLAY_WIDTH / DISPLAY_HEIGHT
+    uint16_t        height;
+    uint8_t         planes;         // bit planes per frame, must match the configured number of planes
+    uint8_t         flags;          // HUB75_ANIM_FMT_xxx
+    uint16_t        frameCount;
+    uint16_t        frameTicks;     // BCM cycles each frame is shown
+    uint16_t        reserved;
+    uint32_t        frameWords;     // 32 bit words per frame
+    const uint32_t* frames;         // frameCount * frameWords words, or word RLE stream
+    const uint32_t* offsets;        // RLE only: start of each frame in frames
+} hub75_anim_t;
+
+#define HUB75_ANIM_FMT_RLE  (1 << 0)        // frames are word RLE compressed, see hub75_encode.h
+#define HUB75_ANIM_FMT_ROWS(order)  ((order) << 1)      // row order the frames are encoded for, must match hub75_set_schedule()
+#define HUB75_ANIM_ROWS(flags)      (((flags) >> 1) & 3)
+
+#define HUB75_ANIM_LOOP     (1 << 0)        // restart at the first frame after the last one
+#define HUB75_ANIM_STAGED   (1 << 1)        // copy frames into RAM through the XIP streaming FIFO before showing them
+
+// Row elision modes, see hub75_set_elision()
+#define HUB75_ELIDE_OFF     0
+#define HUB75_ELIDE_ROWS    1               // skip scan rows that are black in all planes
+
+// Row generator: fills line with the DISPLAY_WIDTH pixels of image line y
+typedef void (*hub75_row_fn)(int y, rgb_t* line, void* ctx);
 
 // Amount of pixels per framebuffer
 #define DISPLAY_FRAMEBUFFER_SIZE (DISPLAY_WIDTH * DISPLAY_HEIGHT)
@@ -215,13 +252,46 @@ typedef uint32_t	rgb_t;
 // Scan factor of the display
 #define DISPLAY_SCAN 32
 
+// Number of scan rows encoded and published at once by hub75_update_stream()
+#ifndef HUB75_STREAM_BAND
+#define HUB75_STREAM_BAND 4
+#endif
+
+// Max. time in us hub75_update_stream() waits for the beam to leave a band
+#define HUB75_STREAM_TIMEOUT 200
+
+// RAM budget in bytes for pre-encoded frames (a frame with 8 planes needs 16 KB on 64x64, 64 KB on 128x128).
+// Off by default on 128x128, where framebuffer and canvas already take 128 KB.
+#ifndef HUB75_CACHE_SIZE
+#if DISPLAY_WIDTH == 128
+#define HUB75_CACHE_SIZE 0
+#else
+#define HUB75_CACHE_SIZE (32 * 1024)
+#endif
+#endif
+
+// Max. number of cached frames
+#define HUB75_CACHE_SLOTS 16
+
+// Words of a ticker strip of width x height pixels for hub75_ticker_setup()
+#define HUB75_TICKER_WORDS(width, height) \
+    (((width) + DISPLAY_WIDTH - 1) / DISPLAY_WIDTH * (DISPLAY_WIDTH == 64 ? HUB75_64_ROW_WORDS(64) : HUB75_128_ROW_WORDS(128)) * DISPLAY_MAXPLANES * (height))
+
+// The width of a ticker strip is a multiple of the columns of a framebuffer word
+#define HUB75_TICKER_ALIGN  (DISPLAY_WIDTH == 64 ? 4 : 2)
+
 
 /*! \brief Configure and start the HUB75 driver hardware
  *  \ingroup HUB75
  *
  * \param bpp Sets the number of bit planes to be used
- * The driver supports from 4 up to 8 pixel planes. This function first stops all driver operation
- * currently running and then reconfigures all required PIO and DMA devices. 
+ * This function first stops all driver operation currently running and then reconfigures all
+ * required PIO and DMA devices.
+ * The BCM version supports up to DISPLAY_MAXPLANES (max. 12) planes. The planes below the 8 binary weighted
+ * planes are shown only once per BCM cycle with an OE pulse shortened to 1/2, 1/4, ... of the normal one,
+ * so the refresh rate stays close to the one of 8 planes.
+ * Down to 1 plane is allowed as well: each BCM cycle is then a single step showing 1 bit per color channel,
+ * for one-colour text (see hub75_update_mono()) at a refresh rate of 255 times the one of 8 planes.
  */
 void hub75_config(int bpp);
 
@@ -238,6 +308,72 @@ void hub75_config(int bpp);
 int hub75_update(rgb_t* image, uint8_t* overlay);
 
 
+/*! \brief Update the LED matrix screen buffer from a 1 bit per pixel bitmap
+ *  \ingroup HUB75
+ *
+ * \param bitmap Packed bitmap, DISPLAY_WIDTH / 8 bytes per line, MSB first = leftmost pixel
+ * \param fg Color of the set pixels
+ * \param bg Color of the clear pixels
+ * Same result as hub75_update() of the expanded image, but the framebuffer words are taken from a
+ * pixel select table and the two colors of each plane, no per pixel encoding. Falls back to the
+ * per pixel encoder with deep colour, temporal or spatial dithering. BCM version only.
+ */
+int hub75_update_mono(const uint8_t* bitmap, rgb_t fg, rgb_t bg);
+
+
+/*! \brief Update the LED matrix screen buffer from an 8 bit palette indexed image
+ *  \ingroup HUB75
+ *
+ * \param image Pointer to the palette indices of the image, one byte per pixel
+ * \param palette 256 colors
+ * \param overlay Pointer to image to be displayed as overlay
+ * Same result as hub75_update() of the expanded image. The palette and the overlay colors are converted
+ * into their bit plane values once per call, so the encoder only looks up and shifts them. Changing the
+ * palette and calling this function again re-encodes the frame without touching the pixel data (color
+ * cycling). Falls back to the per pixel encoder with deep colour, temporal or spatial dithering.
+ * BCM version only.
+ */
+int hub75_update_indexed(const uint8_t* image, const rgb_t* palette, uint8_t* overlay);
+
+
+/*! \brief Update the LED matrix screen buffer from an image with 16 bits per channel
+ *  \ingroup HUB75
+ *
+ * \param image Pointer to image to be displayed
+ * \param overlay Pointer to image to be displayed as overlay (may be NULL)
+ * Same as hub75_update(), but the colors keep up to 12 significant bits for the deep colour planes.
+ * With 8 planes or less the result is the same as for the RGB888 image made of the upper 8 bits.
+ * RGB888 images are expanded by bit replication (0xAB -> 0xABAB), so they use the deep planes as well.
+ */
+int hub75_update_deep(const rgb48_t* image, uint8_t* overlay);
+
+
+/*! \brief Update the LED matrix screen buffer band by band, racing the display beam
+ *  \ingroup HUB75
+ *
+ * \param image Pointer to image to be displayed
+ * \param overlay Pointer to image to be displayed as overlay (may be NULL)
+ * Same result as hub75_update(), but the image is encoded in bands of HUB75_STREAM_BAND scan rows,
+ * starting behind the row currently shifted out by the DMA. Each band is published with all its bit planes
+ * while the beam is outside of it, so the first rows of a new image are visible before the last ones are encoded.
+ * Publishing a band busy-waits up to HUB75_STREAM_TIMEOUT us for the beam to leave it, for DISPLAY_SCAN /
+ * HUB75_STREAM_BAND bands per frame (8 by default); the LEDmx task spends this time in its flush.
+ */
+int hub75_update_stream(rgb_t* image, uint8_t* overlay);
+
+
+/*! \brief Update the LED matrix screen buffer from a row generator
+ *  \ingroup HUB75
+ *
+ * \param rowFn Callback delivering one image line
+ * \param ctx Context pointer passed to rowFn
+ * The encoder pulls the image line by line from rowFn into a small line buffer and encodes it immediately.
+ * Procedural content (gradients, plasma, clocks) needs no full frame RGB buffer this way.
+ * Returns -1 if rowFn is NULL.
+ */
+int hub75_update_generator(hub75_row_fn rowFn, void* ctx);
+
+
 /*! \brief Set master brightness value
  *  \ingroup HUB75
  *
@@ -249,8 +385,250 @@ void    hub75_set_masterbrightness(int brt);
 /*! \brief Set overlay color with index 
  *  \ingroup HUB75
  *
- * \param index Index in overlay color table (range 1..15)
+ * \param index Index in overlay color table (range 1..15, BCM version 1..255)
  * \param color Color to be set (RGB value)
- * Set a color in the overlay color lookup table. This table has 15 entries for 15 colors
+ * Set a color in the overlay color lookup table. This table has 15 entries for 15 colors,
+ * 255 in the BCM version (15 usable with HUB75_OVERLAY_NIBBLE)
  */
 void    hub75_set_overlaycolor(int index, rgb_t color);
+
+
+
+/*! \brief Set the blend mode of an overlay color
+ *  \ingroup HUB75
+ *
+ * \param index Index in overlay color table (range 1..255)
+ * \param mode HUB75_BLEND_REPLACE (default), HUB75_BLEND_ADD (saturating) or HUB75_BLEND_MIX (50%)
+ * The overlay pixels of this color are blended onto the image by the encoder. BCM version only.
+ */
+void    hub75_set_overlayblend(int index, int mode);
+
+
+
+/*! \brief Set the format of the overlay buffers passed to the update functions
+ *  \ingroup HUB75
+ *
+ * \param format HUB75_OVERLAY_BYTE (default, one byte per pixel) or HUB75_OVERLAY_NIBBLE
+ * (4 bits per pixel, DISPLAY_WIDTH / 2 bytes per line, even pixel in the low nibble). BCM version only.
+ */
+void    hub75_set_overlayformat(int format);
+
+
+
+/*! \brief Temporal dithering (frame rate control) for reduced bit plane counts
+ *  \ingroup HUB75
+ *
+ * \param phases 2 or 4 phases, 0 = off
+ * With less than 8 planes the encoder does not simply drop the color LSBs: hub75_update() encodes
+ * the live image once into 'phases' frames in which each pixel is rounded up in as many phases as its
+ * next 1 or 2 dropped bits count, with a per pixel ordered offset. The display interrupt shows the next
+ * phase every BCM cycle, so no encoding is needed per visible frame.
+ * Phase frames use the unused part of the framebuffer and then the frame cache pool, all cached frames are dropped.
+ * Returns the number of phases in use (fewer if RAM is short, 0 with 8 or more planes) or -1. BCM version only.
+ */
+int     hub75_set_frc(int phases);
+
+
+
+/*! \brief Select the plane and row schedule of the BCM cycle
+ *  \ingroup HUB75
+ *
+ * \param chunks MSB split: the BCM cycle is cut into this many chunks (power of 2), each showing an equal share
+ * of the heavy planes. 1 is classic BCM (MSB as one block, lowest refresh), 0 (default) the maximum,
+ * which shows the MSB every other step and moves the flicker to the highest frequencies.
+ * \param order scan order of the rows within a step: HUB75_ROWS_LINEAR (default), HUB75_ROWS_INTERLACED
+ * or HUB75_ROWS_BITREV; non linear orders spread rolling shutter bands of cameras over the panel.
+ * Takes effect with the next hub75_config(). Pre-encoded assets must be built for the same row order.
+ * BCM version only.
+ */
+void    hub75_set_schedule(int chunks, int order);
+
+
+
+/*! \brief Skip black scan rows to raise the refresh rate of sparse content
+ *  \ingroup HUB75
+ *
+ * \param mode HUB75_ELIDE_OFF (default) or HUB75_ELIDE_ROWS
+ * The encoder records the scan rows with lit pixels. With HUB75_ELIDE_ROWS the display DMA only shifts out
+ * those rows (at least 12 per BCM step), so each step gets shorter and the refresh rate rises by up to 32 / 12.
+ * The OE window of the frame is shortened by the same factor, so the brightness stays the same; very low
+ * master brightness limits how many rows can be skipped. Applies to frames encoded by hub75_update(),
+ * hub75_update_generator() and hub75_update_deep(), not to deep colour, temporal dithering, cached frames
+ * or animations. hub75_update_stream() falls back to hub75_update(). BCM version only.
+ */
+void    hub75_set_elision(int mode);
+
+
+
+/*! \brief Spatial dithering for reduced bit plane counts
+ *  \ingroup HUB75
+ *
+ * \param mode HUB75_DITHER_NONE, HUB75_DITHER_ORDERED (4x4 Bayer matrix) or HUB75_DITHER_FS (Floyd-Steinberg)
+ * With less than 8 planes the encoder quantizes each fetched line to bitPlanes bits with the given
+ * dithering instead of dropping the LSBs. Integer only; error diffusion uses a one line error buffer.
+ * Not used while temporal dithering (hub75_set_frc()) is active. BCM version only.
+ */
+void    hub75_set_dither(int mode);
+
+
+
+/*! \brief Set the color correction of the encoder
+ *  \ingroup HUB75
+ *
+ * \param cc Gamma curve (HUB75_GAMMA_CIE1931 or exponent, 1.0 = off), R/G/B gain (255 = 1.0) and panel channel order
+ * The correction tables are built once here and applied while the encoder fetches the pixels,
+ * so it costs nothing per frame. The corrected levels have 16 bits, the deep colour planes use them.
+ * Frames already encoded (e.g. in the frame cache) keep their colors. BCM version only.
+ */
+void    hub75_set_colorcorrection(const hub75_color_t* cc);
+
+
+
+/*! \brief Encode a frame into the frame cache
+ *  \ingroup HUB75
+ *
+ * \param key Caller defined key of the frame
+ * \param image Pointer to image to be encoded
+ * \param overlay Pointer to overlay image (may be NULL)
+ * The frame is encoded once into a retained buffer in framebuffer format. If the cache budget
+ * (HUB75_CACHE_SIZE) is exhausted, the least recently used frame is evicted. The frame on screen is never evicted.
+ * Cached frames keep the master brightness and overlay colors of the time they were stored.
+ * Returns -1 if no slot is available.
+ */
+int     hub75_cache_store(uint32_t key, rgb_t* image, uint8_t* overlay);
+
+/*! \brief Show a cached frame
+ *  \ingroup HUB75
+ *
+ * \param key Key of a frame stored with hub75_cache_store()
+ * Switches the display DMA to the cached frame at the end of the current BCM cycle. No encoding takes place.
+ * The next hub75_update() switches back to the live framebuffer.
+ * Returns -1 if the key is not cached.
+ */
+int     hub75_cache_show(uint32_t key);
+
+/*! \brief Store a frame of a pre-encoded animation in the frame cache
+ *  \ingroup HUB75
+ *
+ * \param key Caller defined key of the frame
+ * \param anim Animation, e.g. generated by the hub75asset tool
+ * \param frame Index of the frame
+ * Plain frames are copied, RLE compressed frames are decoded into the cache slot.
+ * Returns -1 if the animation does not match the panel or no slot is available.
+ */
+int     hub75_cache_store_anim(uint32_t key, const hub75_anim_t* anim, int frame);
+
+/*! \brief Remove a frame from the frame cache
+ *  \ingroup HUB75
+ *
+ * \param key Key of the frame. A frame currently on screen is kept.
+ */
+void    hub75_cache_drop(uint32_t key);
+
+/*! \brief Remove all frames from the frame cache
+ *  \ingroup HUB75
+ *
+ * Called by hub75_config(), because cached frames depend on the number of bit planes.
+ */
+void    hub75_cache_clear(void);
+
+
+
+/*! \brief Encode a band of marquee text (or any wide image) for scrolling without re-encoding
+ *  \ingroup HUB75
+ *
+ * \param strip Buffer of HUB75_TICKER_WORDS(width, height) words, kept by the driver until hub75_ticker_stop()
+ * \param image width x height pixels (same format as the images of hub75_update()), shown circularly
+ * \param top First image line of the band on the panel
+ * The band is encoded once into bit planes wider than the panel. Every frame encoded into the live framebuffer
+ * (all hub75_update functions) takes the band lines from the strip, starting at the scroll position, and
+ * hub75_ticker_refresh() updates just the band lines when nothing else changes. The framebuffer packs
+ * several columns into one word, so a pixel offset is a funnel shift of two encoded words, nothing is
+ * encoded per frame. Lines shifted out in the same scan row as the band (e.g. line top + 32) are kept.
+ * The strip is encoded with the current color correction, without spatial dithering; hub75_config()
+ * stops the ticker. Returns -1 for a band outside of the panel and for a width that is not a multiple of
+ * HUB75_TICKER_ALIGN (the strip wraps around at a word boundary), pad the image instead. BCM version only.
+ */
+int     hub75_ticker_setup(uint32_t* strip, const rgb_t* image, int width, int height, int top);
+
+/*! \brief Set the scroll position and speed of the ticker
+ *  \ingroup HUB75
+ *
+ * \param pos Strip column at the left panel edge, 16.16 fixed point
+ * \param speed Columns per BCM cycle, 16.16 fixed point, negative scrolls right
+ * The display DMA interrupt advances the position at the end of each BCM cycle, so the speed does not
+ * depend on the frame rate of the caller. The new position shows with the next encoded frame or hub75_ticker_refresh(),
+ * each of them takes the position once for all band rows.
+ */
+void    hub75_ticker_scroll(int32_t pos, int32_t speed);
+
+/*! \brief Current scroll position of the ticker (16.16 columns)
+ *  \ingroup HUB75
+ */
+int32_t hub75_ticker_pos(void);
+
+/*! \brief Copy the band lines at the current scroll position into the live framebuffer
+ *  \ingroup HUB75
+ *
+ * Costs a few instructions per framebuffer word of the band instead of encoding a frame.
+ */
+void    hub75_ticker_refresh(void);
+
+/*! \brief Stop the ticker, the next encoded frame shows the image lines again
+ *  \ingroup HUB75
+ */
+void    hub75_ticker_stop(void);
+
+
+
+/*! \brief Remap the scan rows shown by the display without re-encoding
+ *  \ingroup HUB75
+ *
+ * \param map 32 entries: map[y] is the scan row whose encoded data is shown on scan row y, NULL = identity
+ * Only the row runs of the display DMA change, the row addresses of ctrlBuffer stay, so scrolling,
+ * swapping and doubling rows costs no encoding and the map applies to every frame shown (cached frames
+ * and animations as well). It takes over at the end of the BCM cycle. A scan row carries the image
+ * lines y, y + 32 (and y + 64, y + 96 on 128x128), they always move together. Row elision pauses from the
+ * next encoded frame on and hub75_update_stream() falls back to hub75_update() while a map is set.
+ * Returns -1 for an entry >= 32 and for any map but the identity with deep colour (bpp > 8), where the
+ * first shifted row carries the OE window of the previous plane. hub75_config() clears the map. BCM version only.
+ */
+int     hub75_set_rowmap(const uint8_t* map);
+
+/*! \brief Scroll all scan rows up by 'rows' through the row map
+ *  \ingroup HUB75
+ *
+ * \param rows Scan rows, wraps around modulo 32, 0 = no scroll
+ * Scan row y shows the data of scan row (y + rows) % 32, so on a 64x64 panel the upper and the lower
+ * half scroll in place. See hub75_set_rowmap().
+ */
+int     hub75_set_vscroll(int rows);
+
+
+
+/*! \brief Play a pre-encoded animation
+ *  \ingroup HUB75
+ *
+ * \param anim Animation with frames in framebuffer format, usually in XIP flash
+ * \param flags HUB75_ANIM_LOOP, HUB75_ANIM_STAGED
+ * The display DMA reads the frames directly from flash and the DMA interrupt advances the frames,
+ * so playback needs no CPU and no RAM copy. With HUB75_ANIM_STAGED each frame is copied into RAM through
+ * the XIP streaming FIFO by a spare DMA channel while the previous one is shown; the frame cache pool
+ * is used as second buffer then and the cache is cleared. Frames carry the brightness they were encoded with.
+ * RLE compressed animations cannot be played directly, use hub75_cache_store_anim() for them.
+ * Returns -1 if the animation does not match the panel or the configured planes, and for HUB75_ANIM_STAGED
+ * also if the frames are not in XIP flash, the cache pool is too small or temporal dithering is active.
+ */
+int     hub75_anim_play(const hub75_anim_t* anim, int flags);
+
+/*! \brief Stop a running animation
+ *  \ingroup HUB75
+ *
+ * Any hub75_update() (before it encodes) or hub75_cache_show() stops the animation as well.
+ */
+void    hub75_anim_stop(void);
+
+/*! \brief Check if an animation is playing
+ *  \ingroup HUB75
+ */
+bool    hub75_anim_running(void);
@@ -0,0 +1,715 @@
+/*****************************************************
+ *
+ *	LED matrix driver for Raspberry RP2040
+ *	(c) Peter Schulten, Mülheim, Germany
+ *	peter_(at)_pitschu.de
+ *
+ *  Unmodified reproduction and distribution of this entire
+ *  source code in any form is permitted provided the above
+ *  notice is preserved.
+ *  I make this source code available free of charge and therefore
+ *  offer neither support nor guarantee for its functionality.
+ *  Furthermore, I assume no liability for the consequences of
+ *  its use.
+ *  The source code may only be used and modified for private,
+ *  non-commercial purposes. Any further use requires my consent.
+ *
+ *	History
+ *	25.01.2022	pitschu		Start of work
+ */
+
+// Bit plane encoder of the BCM driver. This file has no SDK dependencies,
+// it is shared by hub75_BCM.c and the host tools, so pre-encoded assets are
+// byte identical to what hub75_update() generates.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+typedef uint32_t	rgb_t;
+
+// 16 bits per channel, used for bit depths above 8 planes
+typedef struct rgb48_s {
+    uint16_t    r, g, b;
+} rgb48_t;
+
+// R, G, B bit b of a color as 3-bit HUB75 channel value (R = bit 0)
+#define HUB75_PIX_BITS(c, b)  ((((c) >> (b)) & 1) << 2 | (((c) >> (8 + (b))) & 1) << 1 | (((c) >> (16 + (b))) & 1))
+
+// Framebuffer layout of the 64x64 panel: 4 pixels of both halves per word, 8 bits per pixel, OE flag in bit 7
+#define HUB75_64_ROW_WORDS(width)   ((width) / 4)
+#define HUB75_64_PIXEL_BITS         8
+#define HUB75_64_OE_FLAG            (1 << 7)
+
+// Framebuffer layout of the 128x128 panel: 2 columns of all 4 lines per word, 16 bits per column, OE flag in bit 12
+#define HUB75_128_ROW_WORDS(width)  ((width) / 2)
+#define HUB75_128_PIXEL_BITS        16
+#define HUB75_128_OE_FLAG           (1 << 12)
+
+
+/*
+ * Limit a master brightness value as set by hub75_set_masterbrightness()
+ */
+static inline int hub75_brightness_limit(int brt, int width)
+{
+    brt += 4;       // OE will be always HIGH during the last 4 pixels
+    if (brt < 4) brt = 4;
+    if (brt > (width - 1)) brt = (width - 1);
+    return brt;
+}
+
+
+
+/*
+ * OE flags of one framebuffer row: OE is enabled for the first 'brightness' pixels (columns) of a row
+ */
+static inline void hub75_oe_row(uint32_t* oe, int words, int pixelBits, uint32_t flag, int brightness)
+{
+    int brtCnt = 0;
+
+    for (int x = 0; x < words; x++)
+    {
+        uint32_t flags = 0;
+
+        for (int n = 0; n < 32 / pixelBits; n++)
+        {
+            if (++brtCnt > brightness)
+                flags |= flag << (n * pixelBits);
+        }
+        oe[x] = flags;
+    }
+}
+
+
+
+/*
+ * Brightness value (see hub75_oe_row) of deep colour plane n: its OE window is 1/2^n of the one of
+ * master brightness 'brt', rounded to whole columns
+ */
+static inline int hub75_short_brightness(int brt, int width, int n)
+{
+    int on = (width - 4) - brt;     // columns with OE active
+    int len = (on > 0) ? (on + (1 << (n - 1))) >> n : 0;
+
+    return (width - 4) - len;
+}
+
+
+
+// BCM schedules, see hub75_set_schedule(): order of the scan rows within one BCM step
+#define HUB75_ROWS_LINEAR       0       // 0, 1, 2, ... 31
+#define HUB75_ROWS_INTERLACED   1       // even rows, then odd rows
+#define HUB75_ROWS_BITREV       2       // bit reversed row address: 0, 16, 8, 24, ...
+
+/*
+ * Plane sequence of one BCM cycle of 'planes' binary weighted planes: (1 << planes) - 1 steps of equal
+ * length, steps[i] is the weight exponent of the plane shown in step i (0 = LSB).
+ * The cycle is cut into 'chunks' (power of 2, 1 ... 1 << (planes - 1)); planes of at least that weight show
+ * an equal block in each chunk, lighter planes are spread over the chunks in ruler order.
+ * chunks = 1 is classic BCM with the MSB as one block, the maximum (or 0) shows the MSB every other step.
+ * The sequence is rotated to end with an MSB step, the last plane read from the frame buffer.
+ */
+static inline void hub75_bcm_schedule(uint8_t* steps, int planes, int chunks)
+{
+    int c = 0;
+    int len = (1 << planes) - 1;
+    int i;
+
+    while (c < planes - 1 && (chunks <= 0 || (2 << c) <= chunks))
+        c++;
+
+    i = (c < planes - 1) ? len - (1 << (planes - 1 - c)) : 0;   // the leading MSB block goes to the end
+    for (int j = 0; j < (1 << c); j++)
+    {
+        int low = 0;        // lowest set bit of j + 1
+
+        while (!((j + 1) & (1 << low)))
+            low++;
+
+        for (int b = planes - 1; b >= 0; b--)
+        {
+            if (b >= c)
+            {
+                for (int n = 0; n < (1 << (b - c)); n++, i++)
+                    steps[i % len] = b;
+            }
+            else if (low == c - 1 - b)
+                steps[i++ % len] = b;
+        }
+    }
+}
+
+
+
+/*
+ * Scan order of the rows within a BCM step: rowAt[p] is the row (address) shifted out at position p.
+ * rows must be a power of 2.
+ */
+static inline void hub75_row_order(uint8_t* rowAt, int rows, int order)
+{
+    int bits = 0;
+
+    while ((1 << bits) < rows)
+        bits++;
+
+    for (int p = 0; p < rows; p++)
+    {
+        int r = p;
+
+        if (order == HUB75_ROWS_INTERLACED)
+            r = (p < rows / 2) ? 2 * p : 2 * (p - rows / 2) + 1;
+        else if (order == HUB75_ROWS_BITREV)
+        {
+            r = 0;
+            for (int n = 0; n < bits; n++)
+                r |= ((p >> n) & 1) << (bits - 1 - n);
+        }
+        rowAt[p] = r;
+    }
+}
+
+
+
+/*
+ * Pack one scan row of the 64x64 panel (upper and lower line) into 'planes' bit planes,
+ * starting with color bit 'firstBit' (8 - planes for the MSBs of an RGB888 color).
+ * dst points to the row in the first plane, planeStride is the distance to the same row of the next plane.
+ */
+static inline void hub75_pack_row_64(uint32_t* dst, int planeStride, const rgb_t* up, const rgb_t* lo,
+    int words, int firstBit, int planes, const uint32_t* oe)
+{
+    for (int b = firstBit; b < firstBit + planes; b++)
+    {
+        const rgb_t* ip_u = up;
+        const rgb_t* ip_l = lo;
+        uint32_t* fp = dst + (b - firstBit) * planeStride;
+
+        for (int x = 0; x < words; x++)     // 4 pixels per framebuffer word
+        {
+            rgb_t img = oe[x];
+
+            img |= (HUB75_PIX_BITS(ip_u[0], b) | HUB75_PIX_BITS(ip_l[0], b) << 3);
+            img |= (HUB75_PIX_BITS(ip_u[1], b) | HUB75_PIX_BITS(ip_l[1], b) << 3) << 8;
+            img |= (HUB75_PIX_BITS(ip_u[2], b) | HUB75_PIX_BITS(ip_l[2], b) << 3) << 16;
+            img |= (HUB75_PIX_BITS(ip_u[3], b) | HUB75_PIX_BITS(ip_l[3], b) << 3) << 24;
+            ip_u += 4;
+            ip_l += 4;
+
+            *fp++ = img;
+        }
+    }
+}
+
+
+
+/*
+ * Pack one scan row of the 128x128 panel (4 lines: upper/lower half of both HUB75 ports) into 'planes' bit planes.
+ */
+static inline void hub75_pack_row_128(uint32_t* dst, int planeStride, const rgb_t* uu, const rgb_t* lu,
+    const rgb_t* ul, const rgb_t* ll, int words, int firstBit, int planes, const uint32_t* oe)
+{
+    for (int b = firstBit; b < firstBit + planes; b++)
+    {
+        const rgb_t* ip_uu = uu;
+        const rgb_t* ip_lu = lu;
+        const rgb_t* ip_ul = ul;
+        const rgb_t* ip_ll = ll;
+        uint32_t* fp = dst + (b - firstBit) * planeStride;
+
+        for (int x = 0; x < words; x++)     // 2 columns per framebuffer word
+        {
+            rgb_t img = oe[x];
+
+            img |= (HUB75_PIX_BITS(ip_uu[0], b) | HUB75_PIX_BITS(ip_lu[0], b) << 3 |
+                    HUB75_PIX_BITS(ip_ul[0], b) << 6 | HUB75_PIX_BITS(ip_ll[0], b) << 9);
+            img |= (HUB75_PIX_BITS(ip_uu[1], b) | HUB75_PIX_BITS(ip_lu[1], b) << 3 |
+                    HUB75_PIX_BITS(ip_ul[1], b) << 6 | HUB75_PIX_BITS(ip_ll[1], b) << 9) << 16;
+            ip_uu += 2;
+            ip_lu += 2;
+            ip_ul += 2;
+            ip_ll += 2;
+
+            *fp++ = img;
+        }
+    }
+}
+
+
+
+/*
+ * Plane bits of a color for the palette encoder: HUB75_PIX_BITS of color bit firstBit + p in bits 3p .. 3p + 2,
+ * up to 8 planes
+ */
+static inline uint32_t hub75_palette_entry(rgb_t c, int firstBit, int planes)
+{
+    uint32_t e = 0;
+
+    for (int p = 0; p < planes; p++)
+        e |= (uint32_t)HUB75_PIX_BITS(c, firstBit + p) << (3 * p);
+    return e;
+}
+
+
+
+/*
+ * Same as hub75_pack_row_64() for lines of palette entries (see hub75_palette_entry) instead of colors
+ */
+static inline void hub75_pack_entries_64(uint32_t* dst, int planeStride, const uint32_t* up, const uint32_t* lo,
+    int words, int planes, const uint32_t* oe)
+{
+    for (int p = 0; p < planes; p++)
+    {
+        const uint32_t* ip_u = up;
+        const uint32_t* ip_l = lo;
+        uint32_t* fp = dst + p * planeStride;
+        int s = 3 * p;
+
+        for (int x = 0; x < words; x++)     // 4 pixels per framebuffer word
+        {
+            uint32_t img = oe[x];
+
+            img |= ((ip_u[0] >> s) & 7) | ((ip_l[0] >> s) & 7) << 3;
+            img |= (((ip_u[1] >> s) & 7) | ((ip_l[1] >> s) & 7) << 3) << 8;
+            img |= (((ip_u[2] >> s) & 7) | ((ip_l[2] >> s) & 7) << 3) << 16;
+            img |= (((ip_u[3] >> s) & 7) | ((ip_l[3] >> s) & 7) << 3) << 24;
+            ip_u += 4;
+            ip_l += 4;
+
+            *fp++ = img;
+        }
+    }
+}
+
+
+
+/*
+ * Same as hub75_pack_row_128() for lines of palette entries (see hub75_palette_entry) instead of colors
+ */
+static inline void hub75_pack_entries_128(uint32_t* dst, int planeStride, const uint32_t* uu, const uint32_t* lu,
+    const uint32_t* ul, const uint32_t* ll, int words, int planes, const uint32_t* oe)
+{
+    for (int p = 0; p < planes; p++)
+    {
+        const uint32_t* ip_uu = uu;
+        const uint32_t* ip_lu = lu;
+        const uint32_t* ip_ul = ul;
+        const uint32_t* ip_ll = ll;
+        uint32_t* fp = dst + p * planeStride;
+        int s = 3 * p;
+
+        for (int x = 0; x < words; x++)     // 2 columns per framebuffer word
+        {
+            uint32_t img = oe[x];
+
+            img |= ((ip_uu[0] >> s) & 7) | ((ip_lu[0] >> s) & 7) << 3 |
+                   ((ip_ul[0] >> s) & 7) << 6 | ((ip_ll[0] >> s) & 7) << 9;
+            img |= (((ip_uu[1] >> s) & 7) | ((ip_lu[1] >> s) & 7) << 3 |
+                    ((ip_ul[1] >> s) & 7) << 6 | ((ip_ll[1] >> s) & 7) << 9) << 16;
+            ip_uu += 2;
+            ip_lu += 2;
+            ip_ul += 2;
+            ip_ll += 2;
+
+            *fp++ = img;
+        }
+    }
+}
+
+
+
+/*
+ * Pixel select masks of the 1 bit per pixel encoder. A framebuffer word holds 'cols' columns of 'lines' lines
+ * (64x64: 4 x 2, 128x128: 2 x 4); bit (l * cols + cols - 1 - n) of the index i stands for column n of line l,
+ * i.e. the bits of each line are in source order (MSB first). sel[i] has the 3 color bits of all selected
+ * pixels set. sel[255] / 7 has a 1 in the lowest color bit of every pixel, multiplied by a 3-bit channel
+ * value it fills the whole word with that color.
+ */
+static inline void hub75_mono_select(uint32_t* sel, int cols, int lines, int pixelBits)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        uint32_t m = 0;
+
+        for (int l = 0; l < lines; l++)
+            for (int n = 0; n < cols; n++)
+                if (i & (1 << (l * cols + cols - 1 - n)))
+                    m |= 7u << (n * pixelBits + 3 * l);
+        sel[i] = m;
+    }
+}
+
+
+
+/*
+ * Pack one scan row of a 1 bit per pixel bitmap into 'planes' bit planes. src[l] points to the bitmap
+ * line of line l of the word layout, on[p] / off[p] are the foreground / background colors of plane p
+ * spread over all pixels of a word (see hub75_mono_select).
+ */
+static inline void hub75_mono_row(uint32_t* dst, int planeStride, const uint8_t* const* src, int lines, int cols,
+    int words, const uint32_t* sel, const uint32_t* on, const uint32_t* off, int planes, const uint32_t* oe)
+{
+    uint32_t mask = (1u << cols) - 1;
+
+    for (int x = 0; x < words; x++)
+    {
+        int bit = x * cols;
+        uint32_t i = 0;
+
+        for (int l = 0; l < lines; l++)
+            i |= ((src[l][bit >> 3] >> (8 - cols - (bit & 7))) & mask) << (l * cols);
+
+        uint32_t m = sel[i];
+        uint32_t* fp = dst + x;
+
+        for (int p = 0; p < planes; p++, fp += planeStride)
+            *fp = (on[p] & m) | (off[p] & ~m) | oe[x];
+    }
+}
+
+
+
+// Panel channel order: which color of the image drives the R, G and B input of the panel
+#define HUB75_ORDER_RGB     0
+#define HUB75_ORDER_RBG     1
+#define HUB75_ORDER_GRB     2
+#define HUB75_ORDER_GBR     3
+#define HUB75_ORDER_BRG     4
+#define HUB75_ORDER_BGR     5
+
+#define HUB75_GAMMA_CIE1931 0.0f        // gamma value selecting the CIE 1931 lightness curve
+
+// Color correction settings
+typedef struct hub75_color_s {
+    float       gamma;          // HUB75_GAMMA_CIE1931, 1.0 = linear or exponent of a power law curve
+    uint8_t     gain[3];        // R, G, B gain for white balance, 255 = 1.0
+    uint8_t     order;          // HUB75_ORDER_xxx
+} hub75_color_t;
+
+// Correction tables built from hub75_color_t
+typedef struct hub75_lut_s {
+    uint8_t     shift[3];       // position of the image channel driving panel R, G, B in an rgb_t
+    uint16_t    level[3][256];  // 16 bit output level of panel R, G, B
+} hub75_lut_t;
+
+
+/*
+ * True if the settings leave colors unchanged, the encoder skips the tables then
+ */
+static inline int hub75_color_identity(const hub75_color_t* cc)
+{
+    return cc->gamma == 1.0f && cc->order == HUB75_ORDER_RGB &&
+        cc->gain[0] == 255 && cc->gain[1] == 255 && cc->gain[2] == 255;
+}
+
+
+
+/*
+ * Build the correction tables, done once when the settings change
+ */
+static inline void hub75_color_lut(hub75_lut_t* lut, const hub75_color_t* cc)
+{
+    // source channel (R = 16, G = 8, B = 0) of panel R, G, B for each order
+    static const uint8_t order[6][3] = {
+        { 16, 8, 0 }, { 16, 0, 8 }, { 8, 16, 0 }, { 8, 0, 16 }, { 0, 16, 8 }, { 0, 8, 16 } };
+
+    for (int c = 0; c < 3; c++)
+    {
+        lut->shift[c] = order[cc->order < 6 ? cc->order : 0][c];
+
+        for (int v = 0; v < 256; v++)
+        {
+            float x = v / 255.0f;
+            float y;
+
+            if (cc->gamma == HUB75_GAMMA_CIE1931)        // lightness L* = 100 * x
+                y = (x <= 0.08f) ? x * 100.0f / 903.3f : powf((x * 100.0f + 16.0f) / 116.0f, 3.0f);
+            else
+                y = powf(x, cc->gamma);
+            lut->level[c][v] = (uint16_t)(y * cc->gain[c] * (65535.0f / 255.0f) + 0.5f);
+        }
+    }
+}
+
+
+
+/*
+ * Correct one image line. hi receives the 8 MSBs of the corrected levels as rgb_t,
+ * lo (if not NULL) the 8 bits below them for the deep colour planes. src and hi may be the same.
+ */
+static inline void hub75_color_line(const hub75_lut_t* lut, const rgb_t* src, rgb_t* hi, rgb_t* lo, int n)
+{
+    for (int x = 0; x < n; x++)
+    {
+        rgb_t c = src[x];
+        uint32_t r = lut->level[0][(c >> lut->shift[0]) & 0xFF];
+        uint32_t g = lut->level[1][(c >> lut->shift[1]) & 0xFF];
+        uint32_t b = lut->level[2][(c >> lut->shift[2]) & 0xFF];
+
+        hi[x] = ((r >> 8) << 16) | (g & 0xFF00) | (b >> 8);
+        if (lo != NULL)
+            lo[x] = ((r & 0xFF) << 16) | ((g & 0xFF) << 8) | (b & 0xFF);
+    }
+}
+
+
+
+// Overlay formats, see hub75_set_overlayformat()
+#define HUB75_OVERLAY_BYTE      0       // one byte per pixel, colors 1..255
+#define HUB75_OVERLAY_NIBBLE    1       // 4 bits per pixel, even pixel in the low nibble, colors 1..15
+
+// Overlay blend modes, see hub75_set_overlayblend()
+#define HUB75_BLEND_REPLACE     0
+#define HUB75_BLEND_ADD         1       // image + overlay color, saturated per channel
+#define HUB75_BLEND_MIX         2       // 50% image, 50% overlay color
+
+// Bytes of an overlay line of n pixels
+#define HUB75_OVERLAY_STRIDE(n, format)     ((format) == HUB75_OVERLAY_NIBBLE ? (n) / 2 : (n))
+
+
+/*
+ * Overlay value of pixel x of the overlay line op
+ */
+static inline int hub75_overlay_index(const uint8_t* op, int x, int format)
+{
+    if (format == HUB75_OVERLAY_NIBBLE)
+        return (op[x >> 1] >> ((x & 1) * 4)) & 0xF;
+    return op[x];
+}
+
+
+
+/*
+ * Blend an overlay color c onto the image color img, all 3 channels at once
+ */
+static inline rgb_t hub75_blend(rgb_t img, rgb_t c, int mode)
+{
+    if (mode == HUB75_BLEND_ADD)
+    {
+        rgb_t s = ((img & 0x7F7F7F) + (c & 0x7F7F7F)) ^ ((img ^ c) & 0x808080);    // sum mod 256 per channel
+        rgb_t carry = ((img & c) | ((img | c) & ~s)) & 0x808080;
+
+        return (s & 0xFFFFFF) | ((carry >> 7) * 0xFF);
+    }
+    if (mode == HUB75_BLEND_MIX)
+        return ((img >> 1) & 0x7F7F7F) + ((c >> 1) & 0x7F7F7F) + (img & c & 0x010101);
+    return c;
+}
+
+
+
+/*
+ * Apply the overlay line op (format HUB75_OVERLAY_xxx) to an image line of n pixels.
+ * colors and blend are indexed by the overlay value, 0 is transparent.
+ * Runs of transparent pixels are skipped a word (byte format) or a byte (nibble format) at a time.
+ */
+static inline void hub75_overlay_line(rgb_t* line, const uint8_t* op, int n, int format,
+    const rgb_t* colors, const uint8_t* blend)
+{
+    if (format == HUB75_OVERLAY_NIBBLE)
+    {
+        for (int x = 0; x < n; x += 2)
+        {
+            uint32_t v = *op++;
+
+            if (v == 0)
+                continue;
+            for (int k = 0; k < 2; k++, v >>= 4)
+            {
+                int i = v & 0xF;
+
+                if (i != 0)
+                    line[x + k] = hub75_blend(line[x + k], colors[i], blend[i]);
+            }
+        }
+        return;
+    }
+
+    bool aligned = ((uintptr_t)op & 3) == 0;
+
+    for (int x = 0; x < n; x++)
+    {
+        int i;
+
+        if (aligned && (x & 3) == 0 && x + 4 <= n && *(const uint32_t*)&op[x] == 0)
+        {
+            x += 3;
+            continue;
+        }
+        i = op[x];
+        if (i != 0)
+            line[x] = hub75_blend(line[x], colors[i], blend[i]);
+    }
+}
+
+
+
+// Alpha values are 0..255, hub75_alpha_256() scales them to the 0..256 weight of the blends
+#define HUB75_ARGB_ALPHA(c)     ((uint32_t)(c) >> 24)
+
+
+static inline uint32_t hub75_alpha_256(uint32_t a)
+{
+    return a + (a >> 7);
+}
+
+
+
+/*
+ * dst + (src - dst) * a / 256 per channel, a = 0..256. R and B share one multiply: the lane
+ * differences may borrow across the gap between them, adding dst back restores both lanes.
+ */
+static inline rgb_t hub75_alpha_blend(rgb_t dst, rgb_t src, uint32_t a)
+{
+    uint32_t rb = dst & 0xFF00FF;
+    uint32_t g = dst & 0x00FF00;
+
+    rb += (((src & 0xFF00FF) - rb) * a) >> 8;
+    g += (((src & 0x00FF00) - g) * a) >> 8;
+    return (rb & 0xFF00FF) | (g & 0x00FF00);
+}
+
+
+
+/*
+ * Premultiply the color of an ARGB pixel with its alpha, the alpha byte is kept
+ */
+static inline uint32_t hub75_alpha_premultiply(uint32_t argb)
+{
+    uint32_t a = hub75_alpha_256(HUB75_ARGB_ALPHA(argb));
+
+    return (argb & 0xFF000000) | ((((argb & 0xFF00FF) * a) >> 8) & 0xFF00FF) | ((((argb & 0x00FF00) * a) >> 8) & 0x00FF00);
+}
+
+
+
+/*
+ * src + dst * (256 - a) / 256 per channel for a premultiplied ARGB pixel src
+ */
+static inline rgb_t hub75_alpha_over(rgb_t dst, uint32_t src)
+{
+    uint32_t na = 256 - hub75_alpha_256(HUB75_ARGB_ALPHA(src));
+
+    return (src & 0xFFFFFF) + ((((dst & 0xFF00FF) * na) >> 8) & 0xFF00FF) + ((((dst & 0x00FF00) * na) >> 8) & 0x00FF00);
+}
+
+
+
+// Spatial dithering of reduced bit plane counts
+#define HUB75_DITHER_NONE       0
+#define HUB75_DITHER_ORDERED    1       // 4x4 Bayer matrix, stateless
+#define HUB75_DITHER_FS         2       // Floyd-Steinberg error diffusion with a one line error buffer
+
+// Error buffer entries of hub75_dither_fs() for a line of n pixels
+#define HUB75_DITHER_ERR_SIZE(n)    (3 * ((n) + 2))
+
+
+/*
+ * Quantize a line to 'bits' bits per channel with a 4x4 ordered matrix, y is the image line
+ */
+static inline void hub75_dither_ordered(rgb_t* line, int n, int y, int bits)
+{
+    static const uint8_t bayer[4][4] = {
+        { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+    int shift = 8 - bits;
+    uint32_t top = 0xFF >> shift;
+
+    for (int x = 0; x < n; x++)
+    {
+        uint32_t d = ((uint32_t)bayer[y & 3][x & 3] << shift) >> 4;
+        rgb_t c = line[x];
+        rgb_t o = 0;
+
+        for (int ch = 0; ch < 24; ch += 8)
+        {
+            uint32_t q = (((c >> ch) & 0xFF) + d) >> shift;
+
+            if (q > top)
+                q = top;
+            o |= (q << shift) << ch;
+        }
+        line[x] = o;
+    }
+}
+
+
+
+/*
+ * Quantize a line to 'bits' bits per channel with Floyd-Steinberg error diffusion, integer only.
+ * err (HUB75_DITHER_ERR_SIZE(n) entries) holds the errors diffused into this line by the previous one
+ * and receives the errors for the next line; clear it before the first line of a frame.
+ */
+static inline void hub75_dither_fs(rgb_t* line, int n, int bits, int16_t* err)
+{
+    int shift = 8 - bits;
+    int top = 0xFF >> shift;
+
+    for (int ch = 0; ch < 3; ch++)
+    {
+        int16_t* e = err + ch * (n + 2);    // e[x + 1] belongs to pixel x
+        int pos = 16 - ch * 8;              // R, G, B
+        int carry = 0;                      // 7/16 of the error of the left neighbour
+        int acc0 = 0;                       // error for pixel x - 1 of the next line, w/o the 3/16 of pixel x
+        int acc1 = 0;                       // error for pixel x of the next line from pixel x - 1
+
+        for (int x = 0; x < n; x++)
+        {
+            int v = (int)((line[x] >> pos) & 0xFF) + e[x + 1] + carry;
+            int q;
+
+            if (v < 0) v = 0;
+            if (v > 255) v = 255;
+            q = (v + ((1 << shift) >> 1)) >> shift;
+            if (q > top)
+                q = top;
+            line[x] = (line[x] & ~(0xFFu << pos)) | ((rgb_t)(q << shift) << pos);
+
+            int qe = v - (q << shift);
+            int e3 = (qe * 3) >> 4, e5 = (qe * 5) >> 4;
+            carry = (qe * 7) >> 4;
+            e[x] = (int16_t)(acc0 + e3);                    // pixel x - 1 is complete, its slot was read already
+            acc0 = acc1 + e5;
+            acc1 = qe - carry - e3 - e5;                    // 1/16 takes the rounding rest, no error is lost
+        }
+        e[n] = (int16_t)acc0;
+        e[n + 1] = 0;
+    }
+}
+
+
+
+// Word RLE of pre-encoded frames:
+// a token word with bit 31 set is followed by one word repeated (token & 0x7FFFFFFF) times,
+// a token word with bit 31 clear is followed by 'token' literal words.
+#define HUB75_RLE_RUN   0x80000000u
+
+/*
+ * Decode a word RLE stream into 'words' words, returns the number of stream words consumed or -1 on error
+ */
+static inline int hub75_rle_decode(const uint32_t* src, uint32_t* dst, uint32_t words)
+{
+    const uint32_t* sp = src;
+
+    while (words > 0)
+    {
+        uint32_t token = *sp++;
+        uint32_t n = token & ~HUB75_RLE_RUN;
+
+        if (n == 0 || n > words)
+            return -1;
+        words -= n;
+        if (token & HUB75_RLE_RUN)
+        {
+            uint32_t w = *sp++;
+            while (n--)
+                *dst++ = w;
+        }
+        else
+        {
+            while (n--)
+                *dst++ = *sp++;
+        }
+    }
+    return (int)(sp - src);
+}
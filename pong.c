@@ -58,6 +58,7 @@ static int playGame(int para);
 
 #define PLAYER_LEN 10
 #define BALL_SIZE 5
+#define BALL_DIM (BALL_SIZE < 3 ? 3 : (BALL_SIZE > 10 ? 10 : BALL_SIZE))	// ball width and height, 3 .. 10
 
 typedef struct ball_s
 {
@@ -74,6 +75,8 @@ typedef struct player
 
 // Program globals
 static ball_t ball;
+static uint8_t ballPixels[BALL_DIM * BALL_DIM];		// overlay color 3, corners transparent
+static ledmxBitmap_t ballBitmap = { LEDMX_BMP_INDEX8, BALL_DIM, BALL_DIM, BALL_DIM, ballPixels, NULL, 0 };
 static paddle_t player[2];
 int score[] = {0, 0};
 int width, height; //used if fullscreen
@@ -312,12 +315,8 @@ void initPongGame(void)
 
 	ball.x = playGround.r / 2;
 	ball.y = playGround.b / 2;
-	ball.w = BALL_SIZE;
-	if (ball.w < 3)
-		ball.w = 3;
-	if (ball.w > 10)
-		ball.w = 10;
-	ball.h = ball.w;
+	ball.w = BALL_DIM;
+	ball.h = BALL_DIM;
 	ball.dy = 1;
 	ball.dx = 1;
 
@@ -331,6 +330,10 @@ void initPongGame(void)
 	player[1].w = 2;
 	player[1].h = PLAYER_LEN;
 
+	for (int y = 0; y < ball.h; y++)
+		for (int x = 0; x < ball.w; x++)
+			ballPixels[y * ballBitmap.stride + x] =
+				((y == 0 || y == ball.h - 1) && (x == 0 || x == ball.w - 1)) ? 0 : 3;
 }
 
 
@@ -339,7 +342,7 @@ void initPongGame(void)
  */
 int playPongGame(int countDown)
 {
-	int i, x, y;
+	int i;
 
 	LEDmx_getFlushSemaphore();
 
@@ -351,23 +354,9 @@ int playPongGame(int countDown)
 	move_paddle(1, countDown);
 
 	for (i = 0; i < 2; i++)
-	{
-		for (y = 0; y < player[i].h; y++)
-		{
-			for (x = 0; x < player[i].w; x++)
-			{
-				LEDmx_SetOverlayPixel(player[i].x + x, player[i].y + y, 2);
-			}
-		}
-	}
+		LEDmx_Rect(player[i].x, player[i].y, player[i].x + player[i].w - 1, player[i].y + player[i].h - 1, 2, true);
 
-	for (y = 0; y < ball.h; y++)
-	{
-		for (x = 0 + (y == 0 || y == (ball.h - 1) ? 1 : 0); x < ball.w - (y == 0 || y == (ball.h - 1) ? 1 : 0); x++)
-		{
-			LEDmx_SetOverlayPixel(ball.x + x, ball.y + y, 3);
-		}
-	}
+	LEDmx_Blit(ball.x, ball.y, &ballBitmap, LEDMX_BLIT_OVERLAY | LEDMX_BLIT_KEY);
 	LEDmx_putFlushSemaphore();
 
 	return 0;
@@ -0,0 +1,614 @@
+/*****************************************************
+ *
+ *	LED matrix driver for Raspberry RP2040
+ *	(c) Peter Schulten, Mülheim, Germany
+ *	peter_(at)_pitschu.de
+ *
+ *  Unmodified reproduction and distribution of this entire
+ *  source code in any form is permitted provided the above
+ *  notice is preserved.
+ *  I make this source code available free of charge and therefore
+ *  offer neither support nor guarantee for its functionality.
+ *  Furthermore, I assume no liability for the consequences of
+ *  its use.
+ *  The source code may only be used and modified for private,
+ *  non-commercial purposes. Any further use requires my consent.
+ *
+ *	History
+ *	25.01.2022	pitschu		Start of work
+ */
+
+/////////////////////////////////////////////
+//      Host asset compiler
+//      PPM/PNG frames -> pre-encoded hub75_anim_t header
+/////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#include "hub75_encode.h"
+
+#define DISPLAY_SCAN    32
+#define BCM_PLANES      8       // binary weighted planes, planes beyond are deep colour planes with shortened OE
+#define MAX_PLANES      12
+
+typedef struct panel_s {
+    int width, height;
+    int lines;          // image lines shifted out in one scan row
+    int rowWords;       // framebuffer words per scan row
+    int pixelBits;
+    uint32_t oeFlag;
+} panel_t;
+
+typedef struct image_s {
+    int width, height;
+    rgb_t* pix;
+    rgb_t* lo;          // 8 bits below the MSBs of the 16 bit corrected colors for deep colour, NULL = pix
+} image_t;
+
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: hub75asset [options] -o out.h frame.ppm|frame.png ...\n"
+        "  -s 64|128    panel size (64x64 or 128x128), default 64\n"
+        "  -p planes    bit planes 1..12, default 8; planes above 8 are deep colour planes\n"
+        "  -b brt       master brightness as for hub75_set_masterbrightness(), default 20\n"
+        "  -t ticks     BCM cycles each frame is shown, default 1\n"
+        "  -g gamma     color correction curve: exponent or 'cie' (CIE 1931), default 1.0 = off\n"
+        "  -w r,g,b     white balance gains 0..255, default 255,255,255\n"
+        "  -c order     panel channel order rgb, rbg, grb, gbr, brg or bgr, default rgb\n"
+        "  -d dither    none, ordered or fs (Floyd-Steinberg) for less than 8 planes, default none\n"
+        "  -l rows      row order linear, interlaced or bitrev as for hub75_set_schedule(), default linear\n"
+        "  -n name      C name of the animation, default 'asset'\n"
+        "  -r           word RLE compressed output\n");
+    exit(1);
+}
+
+
+
+static uint8_t* read_file(const char* name, size_t* size)
+{
+    FILE* f = fopen(name, "rb");
+    if (f == NULL)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = malloc(*size + 1);
+    if (fread(buf, 1, *size, f) != *size)
+    {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+
+
+/*
+ * Binary PPM (P6) with maxval 255
+ */
+static int load_ppm(const uint8_t* buf, size_t size, image_t* img)
+{
+    int val[3], n = 0;
+    size_t p = 2;
+
+    if (size < 2 || buf[0] != 'P' || buf[1] != '6')
+        return -1;
+
+    while (n < 3 && p < size)
+    {
+        if (buf[p] == '#')
+        {
+            while (p < size && buf[p] != '\n') p++;
+        }
+        else if (buf[p] >= '0' && buf[p] <= '9')
+        {
+            val[n] = 0;
+            while (p < size && buf[p] >= '0' && buf[p] <= '9')
+                val[n] = val[n] * 10 + (buf[p++] - '0');
+            n++;
+            continue;
+        }
+        p++;
+    }
+    p++;        // single white space after maxval
+
+    if (n < 3 || val[2] != 255 || p + (size_t)val[0] * val[1] * 3 > size)
+        return -1;
+
+    img->width = val[0];
+    img->height = val[1];
+    img->pix = malloc(img->width * img->height * sizeof(rgb_t));
+    for (int i = 0; i < img->width * img->height; i++, p += 3)
+        img->pix[i] = (buf[p] << 16) | (buf[p + 1] << 8) | buf[p + 2];
+    return 0;
+}
+
+
+
+#ifdef HAVE_ZLIB
+static uint32_t be32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+
+
+static int paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+
+    if (pa <= pb && pa <= pc) return a;
+    return (pb <= pc) ? b : c;
+}
+
+
+
+/*
+ * Non interlaced PNG, 8 bit gray, gray+alpha, RGB, RGBA or palette
+ */
+static int load_png(const uint8_t* buf, size_t size, image_t* img)
+{
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    uint8_t plte[256 * 3];
+    uint8_t* idat = NULL;
+    size_t idatLen = 0;
+    int depth = 0, type = -1, interlace = 0, bpp = 0;
+    size_t p = 8;
+
+    if (size < 8 || memcmp(buf, sig, 8) != 0)
+        return -1;
+
+    memset(plte, 0, sizeof(plte));
+    while (p + 12 <= size)
+    {
+        uint32_t len = be32(&buf[p]);
+        const uint8_t* tag = &buf[p + 4];
+        const uint8_t* data = &buf[p + 8];
+
+        if (p + 12 + len > size)
+            break;
+        if (!memcmp(tag, "IHDR", 4))
+        {
+            img->width = be32(data);
+            img->height = be32(data + 4);
+            depth = data[8];
+            type = data[9];
+            interlace = data[12];
+        }
+        else if (!memcmp(tag, "PLTE", 4))
+            memcpy(plte, data, len > sizeof(plte) ? sizeof(plte) : len);
+        else if (!memcmp(tag, "IDAT", 4))
+        {
+            idat = realloc(idat, idatLen + len);
+            memcpy(idat + idatLen, data, len);
+            idatLen += len;
+        }
+        else if (!memcmp(tag, "IEND", 4))
+            break;
+        p += 12 + len;
+    }
+
+    switch (type)
+    {
+    case 0: bpp = 1; break;
+    case 2: bpp = 3; break;
+    case 3: bpp = 1; break;
+    case 4: bpp = 2; break;
+    case 6: bpp = 4; break;
+    }
+    if (depth != 8 || bpp == 0 || interlace != 0 || idat == NULL)
+    {
+        free(idat);
+        return -1;
+    }
+
+    size_t stride = (size_t)img->width * bpp;
+    uLongf rawLen = (stride + 1) * img->height;
+    uint8_t* raw = malloc(rawLen);
+    if (uncompress(raw, &rawLen, idat, idatLen) != Z_OK || rawLen != (stride + 1) * img->height)
+    {
+        free(idat);
+        free(raw);
+        return -1;
+    }
+    free(idat);
+
+    // undo the scanline filters in place
+    for (int y = 0; y < img->height; y++)
+    {
+        uint8_t* line = raw + y * (stride + 1);
+        uint8_t* cur = line + 1;
+        uint8_t* prev = (y > 0) ? raw + (y - 1) * (stride + 1) + 1 : NULL;
+
+        for (size_t x = 0; x < stride; x++)
+        {
+            int a = (x >= (size_t)bpp) ? cur[x - bpp] : 0;
+            int b = prev ? prev[x] : 0;
+            int c = (prev && x >= (size_t)bpp) ? prev[x - bpp] : 0;
+
+            switch (line[0])
+            {
+            case 1: cur[x] += a; break;
+            case 2: cur[x] += b; break;
+            case 3: cur[x] += (a + b) / 2; break;
+            case 4: cur[x] += paeth(a, b, c); break;
+            }
+        }
+    }
+
+    img->pix = malloc(img->width * img->height * sizeof(rgb_t));
+    for (int y = 0; y < img->height; y++)
+    {
+        const uint8_t* s = raw + y * (stride + 1) + 1;
+
+        for (int x = 0; x < img->width; x++, s += bpp)
+        {
+            int r, g, b;
+
+            if (type == 3)
+            {
+                r = plte[s[0] * 3]; g = plte[s[0] * 3 + 1]; b = plte[s[0] * 3 + 2];
+            }
+            else if (type == 0 || type == 4)
+                r = g = b = s[0];
+            else
+            {
+                r = s[0]; g = s[1]; b = s[2];
+            }
+            img->pix[y * img->width + x] = (r << 16) | (g << 8) | b;
+        }
+    }
+    free(raw);
+    return 0;
+}
+#endif
+
+
+
+static int load_image(const char* name, image_t* img)
+{
+    size_t size;
+    uint8_t* buf = read_file(name, &size);
+    int rc = -1;
+
+    if (buf == NULL)
+        return -1;
+
+    if (size >= 2 && buf[0] == 'P')
+        rc = load_ppm(buf, size, img);
+#ifdef HAVE_ZLIB
+    else
+        rc = load_png(buf, size, img);
+#endif
+    free(buf);
+    return rc;
+}
+
+
+
+/*
+ * Pack color bits firstBit.. of the lines of one scan row into 'planes' consecutive bit planes
+ */
+static void pack_planes(const panel_t* pn, uint32_t* dst, int planeWords, const rgb_t** l, int firstBit, int planes,
+                        const uint32_t* oe)
+{
+    if (pn->lines == 2)
+        hub75_pack_row_64(dst, planeWords, l[0], l[1], pn->rowWords, firstBit, planes, oe);
+    else
+        hub75_pack_row_128(dst, planeWords, l[0], l[1], l[2], l[3], pn->rowWords, firstBit, planes, oe);
+}
+
+
+
+/*
+ * Encode one image exactly like hub75_update(image, NULL) does on the device,
+ * rowAt[p] is the scan row stored at framebuffer row position p.
+ * oe holds the OE flags of one row for the full window and the deep colour planes 1..planes - 8.
+ */
+static void encode_frame(const panel_t* pn, const image_t* img, int planes, const uint32_t* oe, const uint8_t* rowAt, uint32_t* fb)
+{
+    int planeWords = pn->rowWords * DISPLAY_SCAN;
+    int shortPlanes = (planes > BCM_PLANES) ? planes - BCM_PLANES : 0;
+
+    for (int p = 0; p < DISPLAY_SCAN; p++)
+    {
+        const rgb_t* l[4];
+        const rgb_t* lo[4];
+        uint32_t* dst = &fb[p * pn->rowWords];
+
+        for (int n = 0; n < pn->lines; n++)
+        {
+            l[n] = img->pix + (rowAt[p] + n * DISPLAY_SCAN) * pn->width;
+            lo[n] = (img->lo ? img->lo : img->pix) + (rowAt[p] + n * DISPLAY_SCAN) * pn->width;
+        }
+
+        if (shortPlanes == 0)
+        {
+            pack_planes(pn, dst, planeWords, l, 8 - planes, planes, oe);
+            continue;
+        }
+
+        // same split as hub75_encode_row(): deep colour planes first, longest OE last; the first row
+        // carries the OE flags of the plane shown before it
+        int prev = (p == 0) ? 1 : 0;
+
+        for (int n = 0; n < shortPlanes; n++)
+            pack_planes(pn, dst + n * planeWords, planeWords, lo, 16 - planes + n, 1, &oe[(shortPlanes - n - prev) * pn->rowWords]);
+        dst += shortPlanes * planeWords;
+        pack_planes(pn, dst, planeWords, l, 0, 1, &oe[prev * shortPlanes * pn->rowWords]);
+        pack_planes(pn, dst + planeWords, planeWords, l, 1, BCM_PLANES - 1, oe);
+    }
+}
+
+
+
+/*
+ * Dither an image down to planes bits exactly like hub75_set_dither() does on the device:
+ * the lines of each HUB75 line group (every DISPLAY_SCAN'th) form one error diffusion stream
+ */
+static void dither_image(const panel_t* pn, image_t* img, int planes, int mode)
+{
+    int16_t* err = malloc(HUB75_DITHER_ERR_SIZE(pn->width) * sizeof(int16_t));
+
+    for (int n = 0; n < pn->lines; n++)
+    {
+        memset(err, 0, HUB75_DITHER_ERR_SIZE(pn->width) * sizeof(int16_t));
+        for (int y = 0; y < DISPLAY_SCAN; y++)
+        {
+            rgb_t* line = img->pix + (y + n * DISPLAY_SCAN) * pn->width;
+
+            if (mode == HUB75_DITHER_ORDERED)
+                hub75_dither_ordered(line, pn->width, y + n * DISPLAY_SCAN, planes);
+            else
+                hub75_dither_fs(line, pn->width, planes, err);
+        }
+    }
+    free(err);
+}
+
+
+
+/*
+ * Word RLE, see hub75_encode.h. Returns the number of words written to out
+ */
+static size_t rle_encode(const uint32_t* in, size_t words, uint32_t* out)
+{
+    size_t i = 0, o = 0;
+
+    while (i < words)
+    {
+        size_t run = 1;
+        while (i + run < words && in[i + run] == in[i])
+            run++;
+
+        if (run >= 3)
+        {
+            out[o++] = HUB75_RLE_RUN | (uint32_t)run;
+            out[o++] = in[i];
+            i += run;
+            continue;
+        }
+
+        // literal block up to the next run of 3 or more
+        size_t start = i, n = 0;
+        while (i < words)
+        {
+            if (i + 2 < words && in[i] == in[i + 1] && in[i] == in[i + 2])
+                break;
+            i++;
+            n++;
+        }
+        out[o++] = (uint32_t)n;
+        memcpy(&out[o], &in[start], n * sizeof(uint32_t));
+        o += n;
+    }
+    return o;
+}
+
+
+
+static void write_words(FILE* f, const uint32_t* w, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        fprintf(f, "%s0x%08x,%s", (i % 8) ? " " : "\t", w[i], (i % 8 == 7 || i == n - 1) ? "\n" : "");
+}
+
+
+
+int main(int argc, char** argv)
+{
+    panel_t pn;
+    int size = 64, planes = 8, brt = 20, ticks = 1, rle = 0, dither = HUB75_DITHER_NONE, rows = HUB75_ROWS_LINEAR;
+    const char* name = "asset";
+    const char* outName = NULL;
+    int first = argc;
+    hub75_color_t cc = { 1.0f, { 255, 255, 255 }, HUB75_ORDER_RGB };
+    static const char* orders[6] = { "rgb", "rbg", "grb", "gbr", "brg", "bgr" };
+    static const char* dithers[3] = { "none", "ordered", "fs" };
+    static const char* rowOrders[3] = { "linear", "interlaced", "bitrev" };
+    uint8_t rowAt[DISPLAY_SCAN];
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] != '-')
+        {
+            first = i;
+            break;
+        }
+        if (!strcmp(argv[i], "-r"))
+            rle = 1;
+        else if (i + 1 >= argc)
+            usage();
+        else if (!strcmp(argv[i], "-s"))
+            size = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-p"))
+            planes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-b"))
+            brt = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t"))
+            ticks = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-n"))
+            name = argv[++i];
+        else if (!strcmp(argv[i], "-o"))
+            outName = argv[++i];
+        else if (!strcmp(argv[i], "-g"))
+        {
+            i++;
+            cc.gamma = !strcmp(argv[i], "cie") ? HUB75_GAMMA_CIE1931 : (float)atof(argv[i]);
+        }
+        else if (!strcmp(argv[i], "-w"))
+        {
+            int r, g, b;
+            if (sscanf(argv[++i], "%d,%d,%d", &r, &g, &b) != 3)
+                usage();
+            cc.gain[0] = r; cc.gain[1] = g; cc.gain[2] = b;
+        }
+        else if (!strcmp(argv[i], "-c"))
+        {
+            for (cc.order = 0; cc.order < 6 && strcmp(argv[i + 1], orders[cc.order]); cc.order++)
+                ;
+            if (cc.order == 6)
+                usage();
+            i++;
+        }
+        else if (!strcmp(argv[i], "-d"))
+        {
+            for (dither = 0; dither < 3 && strcmp(argv[i + 1], dithers[dither]); dither++)
+                ;
+            if (dither == 3)
+                usage();
+            i++;
+        }
+        else if (!strcmp(argv[i], "-l"))
+        {
+            for (rows = 0; rows < 3 && strcmp(argv[i + 1], rowOrders[rows]); rows++)
+                ;
+            if (rows == 3)
+                usage();
+            i++;
+        }
+        else
+            usage();
+    }
+    if (outName == NULL || first >= argc || (size != 64 && size != 128) || planes < 1 || planes > MAX_PLANES)
+        usage();
+
+    pn.width = pn.height = size;
+    if (size == 64)
+    {
+        pn.lines = 2;
+        pn.rowWords = HUB75_64_ROW_WORDS(size);
+        pn.pixelBits = HUB75_64_PIXEL_BITS;
+        pn.oeFlag = HUB75_64_OE_FLAG;
+    }
+    else
+    {
+        pn.lines = 4;
+        pn.rowWords = HUB75_128_ROW_WORDS(size);
+        pn.pixelBits = HUB75_128_PIXEL_BITS;
+        pn.oeFlag = HUB75_128_OE_FLAG;
+    }
+
+    int frameCount = argc - first;
+    size_t frameWords = (size_t)planes * pn.rowWords * DISPLAY_SCAN;
+    uint32_t* oe = malloc((1 + MAX_PLANES - BCM_PLANES) * pn.rowWords * sizeof(uint32_t));
+    uint32_t* frames = malloc(frameCount * frameWords * sizeof(uint32_t));
+    uint32_t* packed = malloc(frameCount * (frameWords * 2 + 1) * sizeof(uint32_t));
+    uint32_t* offsets = malloc(frameCount * sizeof(uint32_t));
+    size_t packedWords = 0;
+
+    hub75_row_order(rowAt, DISPLAY_SCAN, rows);
+    // same OE rows as hub75_prepare_oe(): full window, then 1/2, 1/4, ... for the deep colour planes
+    int masterBrt = hub75_brightness_limit(brt, pn.width);
+    hub75_oe_row(oe, pn.rowWords, pn.pixelBits, pn.oeFlag, masterBrt);
+    for (int n = 1; n <= MAX_PLANES - BCM_PLANES; n++)
+        hub75_oe_row(&oe[n * pn.rowWords], pn.rowWords, pn.pixelBits, pn.oeFlag, hub75_short_brightness(masterBrt, pn.width, n));
+
+    // same tables as hub75_set_colorcorrection() builds on the device
+    hub75_lut_t lut;
+    int correct = !hub75_color_identity(&cc);
+    if (correct)
+        hub75_color_lut(&lut, &cc);
+
+    for (int n = 0; n < frameCount; n++)
+    {
+        image_t img = { 0 };
+
+        if (load_image(argv[first + n], &img) != 0)
+        {
+            fprintf(stderr, "hub75asset: cannot read '%s' (binary PPM or 8 bit PNG expected)\n", argv[first + n]);
+            return 1;
+        }
+        if (img.width != pn.width || img.height != pn.height)
+        {
+            fprintf(stderr, "hub75asset: '%s' is %dx%d, panel is %dx%d\n", argv[first + n],
+                img.width, img.height, pn.width, pn.height);
+            return 1;
+        }
+        if (correct)
+        {
+            if (planes > BCM_PLANES)        // deep colour planes take the bits below the 8 MSBs
+                img.lo = malloc(img.width * img.height * sizeof(rgb_t));
+            hub75_color_line(&lut, img.pix, img.pix, img.lo, img.width * img.height);
+        }
+        if (dither != HUB75_DITHER_NONE && planes < 8)
+            dither_image(&pn, &img, planes, dither);
+        encode_frame(&pn, &img, planes, oe, rowAt, &frames[n * frameWords]);
+        free(img.pix);
+        free(img.lo);
+
+        offsets[n] = (uint32_t)packedWords;
+        packedWords += rle_encode(&frames[n * frameWords], frameWords, &packed[packedWords]);
+    }
+
+    FILE* f = fopen(outName, "w");
+    if (f == NULL)
+    {
+        fprintf(stderr, "hub75asset: cannot write '%s'\n", outName);
+        return 1;
+    }
+
+    fprintf(f, "// Generated by hub75asset: %dx%d panel, %d planes, brightness %d, %d frame(s)%s. Do not edit.\n",
+        pn.width, pn.height, planes, brt, frameCount, rle ? ", word RLE" : "");
+    fprintf(f, "#pragma once\n#include \"hub75.h\"\n\n");
+    fprintf(f, "static const uint32_t __attribute__((aligned(4))) %s_frames[] = {\n", name);
+    if (rle)
+        write_words(f, packed, packedWords);
+    else
+        write_words(f, frames, frameCount * frameWords);
+    fprintf(f, "};\n\n");
+
+    if (rle)
+    {
+        fprintf(f, "static const uint32_t %s_offsets[] = {\n", name);
+        write_words(f, offsets, frameCount);
+        fprintf(f, "};\n\n");
+    }
+
+    char flags[64] = "0";
+    if (rows != HUB75_ROWS_LINEAR)
+        snprintf(flags, sizeof(flags), "%sHUB75_ANIM_FMT_ROWS(%d)", rle ? "HUB75_ANIM_FMT_RLE | " : "", rows);
+    else if (rle)
+        strcpy(flags, "HUB75_ANIM_FMT_RLE");
+
+    fprintf(f, "static const hub75_anim_t %s = {\n", name);
+    fprintf(f, "\tHUB75_ANIM_MAGIC, %d, %d, %d, %s, %d, %d, 0, %zu,\n", pn.width, pn.height, planes,
+        flags, frameCount, ticks, frameWords);
+    if (rle)
+        fprintf(f, "\t%s_frames, %s_offsets\n};\n", name, name);
+    else
+        fprintf(f, "\t%s_frames, NULL\n};\n", name);
+    fclose(f);
+
+    fprintf(stderr, "hub75asset: %d frame(s), %zu words%s\n", frameCount, rle ? packedWords : frameCount * frameWords,
+        rle ? " compressed" : "");
+    return 0;
+}
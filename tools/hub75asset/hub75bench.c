@@ -0,0 +1,269 @@
+/*****************************************************
+ *
+ *	LED matrix driver for Raspberry RP2040
+ *	(c) Peter Schulten, Mülheim, Germany
+ *	peter_(at)_pitschu.de
+ *
+ *  Unmodified reproduction and distribution of this entire
+ *  source code in any form is permitted provided the above
+ *  notice is preserved.
+ *  I make this source code available free of charge and therefore
+ *  offer neither support nor guarantee for its functionality.
+ *  Furthermore, I assume no liability for the consequences of
+ *  its use.
+ *  The source code may only be used and modified for private,
+ *  non-commercial purposes. Any further use requires my consent.
+ *
+ *	History
+ *	25.01.2022	pitschu		Start of work
+ */
+
+/////////////////////////////////////////////
+//      Host benchmark of the frame encoder
+//      plain hub75_update() encoding vs. with spatial dithering,
+//      overlay compositing: per pixel select vs. hub75_overlay_line() in both overlay formats,
+//      alpha blending: per channel vs. hub75_alpha_blend() / hub75_alpha_over()
+/////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "hub75_encode.h"
+
+#define DISPLAY_SCAN    32
+#define LOOPS           200
+
+
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+
+/*
+ * Encode one frame the way the driver does: fetch scan row, optionally dither, pack planes
+ */
+static void encode(int size, int planes, int dither, const rgb_t* image, rgb_t* lines, int16_t* err,
+                   const uint32_t* oe, uint32_t* fb)
+{
+    int nLines = size == 64 ? 2 : 4;
+    int rowWords = size == 64 ? HUB75_64_ROW_WORDS(size) : HUB75_128_ROW_WORDS(size);
+    int errSize = HUB75_DITHER_ERR_SIZE(size);
+
+    for (int y = 0; y < DISPLAY_SCAN; y++)
+    {
+        for (int n = 0; n < nLines; n++)
+        {
+            rgb_t* l = &lines[n * size];
+
+            memcpy(l, &image[(y + n * DISPLAY_SCAN) * size], size * sizeof(rgb_t));
+            if (dither == HUB75_DITHER_ORDERED)
+                hub75_dither_ordered(l, size, y + n * DISPLAY_SCAN, planes);
+            else if (dither == HUB75_DITHER_FS)
+            {
+                if (y == 0)
+                    memset(&err[n * errSize], 0, errSize * sizeof(int16_t));
+                hub75_dither_fs(l, size, planes, &err[n * errSize]);
+            }
+        }
+        if (size == 64)
+            hub75_pack_row_64(&fb[y * rowWords], rowWords * DISPLAY_SCAN, &lines[0], &lines[size],
+                              rowWords, 8 - planes, planes, oe);
+        else
+            hub75_pack_row_128(&fb[y * rowWords], rowWords * DISPLAY_SCAN, &lines[0], &lines[size],
+                               &lines[2 * size], &lines[3 * size], rowWords, 8 - planes, planes, oe);
+    }
+}
+
+
+
+/*
+ * Overlay compositing as done before the blend modes: per pixel select of the overlay color
+ */
+static void select_line(rgb_t* dst, const rgb_t* ip, const uint8_t* op, int n, const rgb_t* colors)
+{
+    for (int x = 0; x < n; x++)
+    {
+        rgb_t c = *ip++;
+
+        if (*op != 0)
+            c = colors[*op];
+        op++;
+        *dst++ = c;
+    }
+}
+
+
+
+/*
+ * us per frame for compositing the overlay onto all lines of a size x size image, 'mode' 0 = select,
+ * 1 = hub75_overlay_line() byte format, 2 = nibble format. 'percent' of the pixels are overlay pixels.
+ */
+static double overlay_bench(int size, int mode, int percent, const uint8_t* blend)
+{
+    rgb_t* image = malloc(size * size * sizeof(rgb_t));
+    rgb_t* line = malloc(size * sizeof(rgb_t));
+    uint32_t* ovWords = malloc(size * size);        // word aligned like a static overlay buffer
+    uint8_t* ov = (uint8_t*)ovWords;
+    uint8_t* nib = malloc(size * size / 2);
+    rgb_t colors[256];
+    double t0;
+
+    srand(2);
+    memset(nib, 0, size * size / 2);
+    for (int i = 0; i < 256; i++)
+        colors[i] = i * 0x010203;
+    for (int i = 0; i < size * size; i++)
+    {
+        image[i] = rand() & 0xFFFFFF;
+        ov[i] = (rand() % 100 < percent) ? 1 + rand() % 15 : 0;
+        nib[i / 2] |= ov[i] << ((i & 1) * 4);
+    }
+
+    t0 = now_us();
+    for (int n = 0; n < LOOPS; n++)
+        for (int y = 0; y < size; y++)
+        {
+            if (mode == 0)
+                select_line(line, &image[y * size], &ov[y * size], size, colors);
+            else
+            {
+                memcpy(line, &image[y * size], size * sizeof(rgb_t));
+                if (mode == 1)
+                    hub75_overlay_line(line, &ov[y * size], size, HUB75_OVERLAY_BYTE, colors, blend);
+                else
+                    hub75_overlay_line(line, &nib[y * size / 2], size, HUB75_OVERLAY_NIBBLE, colors, blend);
+            }
+        }
+    t0 = (now_us() - t0) / LOOPS;
+    free(image); free(line); free(ovWords); free(nib);
+    return t0;
+}
+
+
+
+/*
+ * Alpha blending as done per channel: 3 extracts, 3 multiplies and 3 inserts per pixel
+ */
+static rgb_t blend_channels(rgb_t dst, rgb_t src, uint32_t a)
+{
+    rgb_t out = 0;
+
+    for (int ch = 0; ch < 24; ch += 8)
+    {
+        int d = (dst >> ch) & 0xFF;
+        int s = (src >> ch) & 0xFF;
+
+        out |= (rgb_t)(d + (((s - d) * (int)a) >> 8)) << ch;
+    }
+    return out;
+}
+
+
+
+/*
+ * ns per pixel for blending a size x size ARGB sprite onto an image, 'mode' 0 = per channel,
+ * 1 = hub75_alpha_blend(), 2 = hub75_alpha_over() with premultiplied pixels
+ */
+static double alpha_bench(int size, int mode)
+{
+    uint32_t* sprite = malloc(size * size * sizeof(uint32_t));
+    rgb_t* image = malloc(size * size * sizeof(rgb_t));
+    volatile rgb_t sink;
+    double t0;
+
+    srand(3);
+    for (int i = 0; i < size * size; i++)
+    {
+        sprite[i] = ((uint32_t)(1 + rand() % 254) << 24) | (rand() & 0xFFFFFF);
+        if (mode == 2)
+            sprite[i] = hub75_alpha_premultiply(sprite[i]);
+        image[i] = rand() & 0xFFFFFF;
+    }
+
+    t0 = now_us();
+    for (int n = 0; n < LOOPS; n++)
+        for (int i = 0; i < size * size; i++)
+        {
+            uint32_t c = sprite[i];
+
+            if (mode == 0)
+                image[i] = blend_channels(image[i], c & 0xFFFFFF, hub75_alpha_256(HUB75_ARGB_ALPHA(c)));
+            else if (mode == 1)
+                image[i] = hub75_alpha_blend(image[i], c & 0xFFFFFF, hub75_alpha_256(HUB75_ARGB_ALPHA(c)));
+            else
+                image[i] = hub75_alpha_over(image[i], c);
+        }
+    t0 = (now_us() - t0) * 1000 / LOOPS / (size * size);
+    sink = image[0];
+    (void)sink;
+    free(sprite); free(image);
+    return t0;
+}
+
+
+
+int main(void)
+{
+    static const char* names[3] = { "plain", "ordered", "fs" };
+
+    printf("size planes  %10s %10s %10s   (us/frame, ratio to plain)\n", names[0], names[1], names[2]);
+
+    for (int size = 64; size <= 128; size += 64)
+    {
+        int rowWords = size == 64 ? HUB75_64_ROW_WORDS(size) : HUB75_128_ROW_WORDS(size);
+        rgb_t* image = malloc(size * size * sizeof(rgb_t));
+        rgb_t* lines = malloc(4 * size * sizeof(rgb_t));
+        int16_t* err = malloc(4 * HUB75_DITHER_ERR_SIZE(size) * sizeof(int16_t));
+        uint32_t* oe = malloc(rowWords * sizeof(uint32_t));
+        uint32_t* fb = malloc(8 * rowWords * DISPLAY_SCAN * sizeof(uint32_t));
+
+        srand(1);
+        for (int i = 0; i < size * size; i++)
+            image[i] = ((rgb_t)rand() << 8 ^ rand()) & 0xFFFFFF;
+        if (size == 64)
+            hub75_oe_row(oe, rowWords, HUB75_64_PIXEL_BITS, HUB75_64_OE_FLAG, hub75_brightness_limit(20, size));
+        else
+            hub75_oe_row(oe, rowWords, HUB75_128_PIXEL_BITS, HUB75_128_OE_FLAG, hub75_brightness_limit(20, size));
+
+        for (int planes = 4; planes <= 6; planes++)
+        {
+            double us[3];
+
+            for (int d = 0; d < 3; d++)
+            {
+                double t0 = now_us();
+                for (int i = 0; i < LOOPS; i++)
+                    encode(size, planes, d, image, lines, err, oe, fb);
+                us[d] = (now_us() - t0) / LOOPS;
+            }
+            printf("%4d %6d  %10.1f %10.1f %10.1f   (%.2f / %.2f)\n", size, planes,
+                   us[0], us[1], us[2], us[1] / us[0], us[2] / us[0]);
+        }
+        free(image); free(lines); free(err); free(oe); free(fb);
+    }
+
+    uint8_t replace[256] = { 0 }, mixed[256];
+
+    for (int i = 0; i < 256; i++)
+        mixed[i] = i % 3;       // replace, add, mix
+    printf("\noverlay compositing (us/frame): select = per pixel select, byte / nibble = hub75_overlay_line()\n");
+    printf("size  cover  %8s %8s %8s   %8s %8s (add/mix)\n", "select", "byte", "nibble", "byte", "nibble");
+    for (int size = 64; size <= 128; size += 64)
+        for (int cover = 0; cover <= 100; cover += (cover < 10 ? 10 : 90))
+            printf("%4d  %4d%%  %8.1f %8.1f %8.1f   %8.1f %8.1f\n", size, cover,
+                   overlay_bench(size, 0, cover, replace), overlay_bench(size, 1, cover, replace),
+                   overlay_bench(size, 2, cover, replace), overlay_bench(size, 1, cover, mixed),
+                   overlay_bench(size, 2, cover, mixed));
+
+    printf("\nalpha blending (ns/pixel): per channel vs. SWAR hub75_alpha_blend() / premultiplied hub75_alpha_over()\n");
+    printf("size  %8s %8s %8s\n", "channel", "swar", "premul");
+    for (int size = 64; size <= 128; size += 64)
+        printf("%4d  %8.2f %8.2f %8.2f\n", size, alpha_bench(size, 0), alpha_bench(size, 1), alpha_bench(size, 2));
+    return 0;
+}
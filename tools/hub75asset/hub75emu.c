@@ -0,0 +1,258 @@
+/*****************************************************
+ *
+ *	LED matrix driver for Raspberry RP2040
+ *	(c) Peter Schulten, Mülheim, Germany
+ *	peter_(at)_pitschu.de
+ *
+ *  Unmodified reproduction and distribution of this entire
+ *  source code in any form is permitted provided the above
+ *  notice is preserved.
+ *  I make this source code available free of charge and therefore
+ *  offer neither support nor guarantee for its functionality.
+ *  Furthermore, I assume no liability for the consequences of
+ *  its use.
+ *  The source code may only be used and modified for private,
+ *  non-commercial purposes. Any further use requires my consent.
+ *
+ *	History
+ *	25.01.2022	pitschu		Start of work
+ */
+
+/////////////////////////////////////////////
+//      Host emulator of the BCM schedules
+//      light output of one pixel over a BCM cycle for each hub75_set_schedule() setting:
+//      temporal spectrum (flicker) and rolling shutter banding of a camera
+/////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "hub75_encode.h"
+
+#define DISPLAY_SCAN    32
+#define BANDS           6
+#define CAM_PHASES      64      // exposure start times within a BCM cycle
+#define CAM_READOUTS    32      // camera line times swept around the given one
+#define CAM_BINS        4       // spatial frequencies counted as bands (1..4 periods over 32 rows)
+
+static const double bandEdge[BANDS] = { 100, 200, 400, 800, 1600, 1e12 };
+static const char* bandName[BANDS] = { "<100", "<200", "<400", "<800", "<1600", "rest" };
+static const char* rowName[3] = { "linear", "interlaced", "bitrev" };
+
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: hub75emu [options]\n"
+        "  -p planes    binary bit planes 4..8, default 8\n"
+        "  -t us        duration of one BCM step (all scan rows of one plane), default 78 (50 Hz at 8 planes)\n"
+        "  -r us        camera line readout time per panel row (swept 0.5 .. 1.5x), default 125\n"
+        "  -e us        camera exposure time, default 1000\n");
+    exit(1);
+}
+
+
+
+/*
+ * Worst case amplitude (over all levels, relative to full white) of the flicker in each frequency band
+ */
+static void temporal_spectrum(const uint8_t* steps, int planes, double stepUs, double* worst)
+{
+    int len = (1 << planes) - 1;
+    double* w = malloc(len * sizeof(double));
+
+    for (int b = 0; b < BANDS; b++)
+        worst[b] = 0;
+
+    for (int level = 1; level <= len; level++)
+    {
+        double band[BANDS] = { 0 };
+
+        for (int i = 0; i < len; i++)
+            w[i] = (level >> steps[i]) & 1;
+
+        for (int k = 1; k <= len / 2; k++)
+        {
+            double re = 0, im = 0;
+            double f = k * 1e6 / (len * stepUs);
+
+            for (int i = 0; i < len; i++)
+            {
+                re += w[i] * cos(2 * M_PI * k * i / len);
+                im -= w[i] * sin(2 * M_PI * k * i / len);
+            }
+            int b = 0;
+            while (f >= bandEdge[b])
+                b++;
+            band[b] += (re * re + im * im) * 4 / ((double)len * len);     // squared peak amplitude
+        }
+        for (int b = 0; b < BANDS; b++)
+            if (sqrt(band[b]) > worst[b])
+                worst[b] = sqrt(band[b]);
+    }
+    free(w);
+}
+
+
+
+/*
+ * Lit slots of scan row position p before slot t (t >= 0), cum[k] = lit steps among the first k steps of a cycle
+ */
+static int lit_before(const int* cum, int len, int p, int t)
+{
+    int n = (t > p) ? (t - p + DISPLAY_SCAN - 1) / DISPLAY_SCAN : 0;    // steps whose slot p starts before t
+
+    return (n / len) * cum[len] + cum[n % len];
+}
+
+
+
+/*
+ * Rolling shutter: panel row r is exposed from t0 + r * readout for the exposure time.
+ * Returns the worst case (over odd levels from firstLevel on and readout times of 0.5 .. 1.5 x readUs, mean over t0) amplitude
+ * of the coarse bands (1..CAM_BINS periods over the scan rows) in percent of the full white exposure.
+ */
+static double rolling_shutter(const uint8_t* steps, int planes, const uint8_t* rowAt, int firstLevel,
+                              double stepUs, double readUs, double expUs)
+{
+    int len = (1 << planes) - 1;
+    int slots = len * DISPLAY_SCAN;             // one slot = one scan row of one step
+    double slotUs = stepUs / DISPLAY_SCAN;
+    int expSlots = (int)(expUs / slotUs + 0.5);
+    double white = (double)expSlots / DISPLAY_SCAN;
+    uint8_t rowPos[DISPLAY_SCAN];
+    int* cum = malloc((len + 1) * sizeof(int));
+    double cs[CAM_BINS + 1][DISPLAY_SCAN], sn[CAM_BINS + 1][DISPLAY_SCAN];
+    double worst = 0;
+
+    for (int k = 1; k <= CAM_BINS; k++)
+        for (int r = 0; r < DISPLAY_SCAN; r++)
+        {
+            cs[k][r] = cos(2 * M_PI * k * r / DISPLAY_SCAN);
+            sn[k][r] = sin(2 * M_PI * k * r / DISPLAY_SCAN);
+        }
+
+    for (int p = 0; p < DISPLAY_SCAN; p++)
+        rowPos[rowAt[p]] = p;
+
+    for (int level = firstLevel; level <= len; level += 2)
+    {
+        cum[0] = 0;
+        for (int i = 0; i < len; i++)
+            cum[i + 1] = cum[i] + ((level >> steps[i]) & 1);
+
+        for (int rd = 0; rd < CAM_READOUTS; rd++)
+        {
+            double rowSlots = readUs * (0.5 + (double)rd / CAM_READOUTS) / slotUs;
+            double sum = 0;
+
+            for (int ph = 0; ph < CAM_PHASES; ph++)
+            {
+                double c[DISPLAY_SCAN], mean = 0, ac = 0;
+                int t0 = ph * slots / CAM_PHASES;
+
+                for (int r = 0; r < DISPLAY_SCAN; r++)
+                {
+                    int start = t0 + (int)(r * rowSlots + 0.5);
+                    int p = rowPos[r];
+
+                    c[r] = lit_before(cum, len, p, start + expSlots) - lit_before(cum, len, p, start);
+                    mean += c[r];
+                }
+                mean /= DISPLAY_SCAN;
+
+                for (int k = 1; k <= CAM_BINS; k++)
+                {
+                    double re = 0, im = 0;
+                    for (int r = 0; r < DISPLAY_SCAN; r++)
+                    {
+                        re += (c[r] - mean) * cs[k][r];
+                        im -= (c[r] - mean) * sn[k][r];
+                    }
+                    ac += (re * re + im * im) * 4 / (DISPLAY_SCAN * DISPLAY_SCAN);
+                }
+                sum += sqrt(ac) / white;
+            }
+            if (sum / CAM_PHASES > worst)
+                worst = sum / CAM_PHASES;
+        }
+    }
+    free(cum);
+    return worst * 100;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    int planes = 8;
+    double stepUs = 78, readUs = 125, expUs = 1000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+            usage();
+        else if (!strcmp(argv[i], "-p"))
+            planes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t"))
+            stepUs = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-r"))
+            readUs = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-e"))
+            expUs = atof(argv[++i]);
+        else
+            usage();
+    }
+    if (planes < 4 || planes > 8 || stepUs <= 0 || readUs < 0 || expUs <= 0)
+        usage();
+
+    int len = (1 << planes) - 1;
+    uint8_t steps[255];
+    uint8_t rowAt[DISPLAY_SCAN];
+
+    printf("%d planes, %d steps of %.1f us, BCM cycle %.1f Hz\n\n", planes, len, stepUs, 1e6 / (len * stepUs));
+    printf("temporal spectrum: worst case flicker amplitude in %% of full white per band (Hz)\n");
+    printf("chunks ");
+    for (int b = 0; b < BANDS; b++)
+        printf("%8s", bandName[b]);
+    printf("\n");
+
+    for (int chunks = 1; chunks <= (1 << (planes - 1)); chunks *= 2)
+    {
+        double worst[BANDS];
+
+        hub75_bcm_schedule(steps, planes, chunks);
+        temporal_spectrum(steps, planes, stepUs, worst);
+        printf("%6d ", chunks);
+        for (int b = 0; b < BANDS; b++)
+            printf("%8.1f", worst[b] * 100);
+        printf("\n");
+    }
+
+    printf("\nrolling shutter: worst case band contrast in %% of white (exposure %.0f us, %.0f us readout per row)\n", expUs, readUs);
+    printf("chunks ");
+    for (int o = 0; o < 3; o++)
+        printf("%11s", rowName[o]);
+    printf("\n");
+
+    for (int chunks = 1; chunks <= (1 << (planes - 1)); chunks *= 2)
+    {
+        hub75_bcm_schedule(steps, planes, chunks);
+        printf("%6d ", chunks);
+        for (int o = 0; o < 3; o++)
+        {
+            hub75_row_order(rowAt, DISPLAY_SCAN, o);
+            printf("%11.1f", rolling_shutter(steps, planes, rowAt, 1, stepUs, readUs, expUs));
+        }
+        printf("\n");
+    }
+    printf(" white ");      // all planes lit: only the row order matters
+    for (int o = 0; o < 3; o++)
+    {
+        hub75_row_order(rowAt, DISPLAY_SCAN, o);
+        printf("%11.1f", rolling_shutter(steps, planes, rowAt, len, stepUs, readUs, expUs));
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,379 @@
+/*****************************************************
+ *
+ *	LED matrix driver for Raspberry RP2040
+ *	(c) Peter Schulten, Mülheim, Germany
+ *	peter_(at)_pitschu.de
+ *
+ *  Unmodified reproduction and distribution of this entire
+ *  source code in any form is permitted provided the above
+ *  notice is preserved.
+ *  I make this source code available free of charge and therefore
+ *  offer neither support nor guarantee for its functionality.
+ *  Furthermore, I assume no liability for the consequences of
+ *  its use.
+ *  The source code may only be used and modified for private,
+ *  non-commercial purposes. Any further use requires my consent.
+ *
+ *	History
+ *	25.01.2022	pitschu		Start of work
+ */
+
+/////////////////////////////////////////////
+//      Host font compiler
+//      BDF font -> ledfont_t header for LEDfont_DrawText(),
+//      1 bpp as drawn or 4 bpp coverage of a supersampled (larger) BDF font
+/////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#define MAX_GLYPHS      4096
+#define MAX_KERNS       1024
+
+typedef struct glyph_s {
+    uint32_t code;
+    int w, h, dx, dy, advance;
+    uint8_t* cover;         // w * h levels 0..15
+} glyph_t;
+
+typedef struct kern_s {
+    uint32_t left, right;
+    int dx;
+} kern_t;
+
+static glyph_t glyphs[MAX_GLYPHS];
+static kern_t kerns[MAX_KERNS];
+
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: hub75font [options] -o out.h font.bdf\n"
+        "  -s factor    supersampling 2..8: the BDF font is factor times the output size, 4 bpp output, default 1 = 1 bpp\n"
+        "  -k file      kerning pairs, one 'left right dx' per line, characters as UTF-8 or U+hex, dx in output pixels\n"
+        "  -n name      C name of the font, default 'font'\n");
+    exit(1);
+}
+
+
+
+static int floor_div(int n, int d)
+{
+    return (n >= 0) ? n / d : -((-n + d - 1) / d);
+}
+
+
+
+static int cmp_glyph(const void* a, const void* b)
+{
+    uint32_t ca = ((const glyph_t*)a)->code, cb = ((const glyph_t*)b)->code;
+    return (ca > cb) - (ca < cb);
+}
+
+
+
+static int cmp_kern(const void* a, const void* b)
+{
+    const kern_t* ka = a;
+    const kern_t* kb = b;
+    uint32_t va = (ka->left << 16) | ka->right, vb = (kb->left << 16) | kb->right;
+    return (va > vb) - (va < vb);
+}
+
+
+
+/*
+ * Character of the kerning file: one UTF-8 character or U+hex
+ */
+static int parse_char(const char* s, uint32_t* code)
+{
+    const uint8_t* p = (const uint8_t*)s;
+    int n;
+
+    if ((s[0] == 'U' || s[0] == 'u') && s[1] == '+')
+        return sscanf(s + 2, "%x", code) == 1 ? 0 : -1;
+    if (p[0] < 0x80)
+        *code = p[0], n = 0;
+    else if ((p[0] & 0xE0) == 0xC0)
+        *code = p[0] & 0x1F, n = 1;
+    else if ((p[0] & 0xF0) == 0xE0)
+        *code = p[0] & 0x0F, n = 2;
+    else
+        *code = p[0] & 0x07, n = 3;
+    for (int i = 1; i <= n; i++)
+    {
+        if ((p[i] & 0xC0) != 0x80)
+            return -1;
+        *code = (*code << 6) | (p[i] & 0x3F);
+    }
+    return (p[n + 1] == 0) ? 0 : -1;
+}
+
+
+
+/*
+ * Reduce one BDF glyph (bitmap rows of w bits, bottom left corner at xoff, yoff from the origin) by the
+ * supersampling factor: an output pixel covers factor x factor BDF pixels, its level is their ink count.
+ * Empty border lines and columns are cropped.
+ */
+static void reduce_glyph(glyph_t* g, const uint8_t* ink, int w, int h, int xoff, int yoff, int factor, int ascent)
+{
+    int x0 = floor_div(xoff, factor), x1 = floor_div(xoff + w - 1, factor);
+    int top = floor_div(yoff + h - 1, factor), bottom = floor_div(yoff, factor);
+    int ow = x1 - x0 + 1, oh = top - bottom + 1;
+    int* count = calloc(ow * oh, sizeof(int));
+    int l = ow, r = -1, t = oh, b = -1;
+
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            if (ink[y * w + x])
+                count[(top - floor_div(yoff + h - 1 - y, factor)) * ow + floor_div(xoff + x, factor) - x0]++;
+
+    for (int i = 0; i < ow * oh; i++)
+    {
+        count[i] = (count[i] * 15 + factor * factor / 2) / (factor * factor);
+        if (count[i])
+        {
+            l = (i % ow < l) ? i % ow : l;
+            r = (i % ow > r) ? i % ow : r;
+            t = (i / ow < t) ? i / ow : t;
+            b = (i / ow > b) ? i / ow : b;
+        }
+    }
+
+    if (r < 0 || w == 0 || h == 0)
+    {
+        g->w = g->h = g->dx = g->dy = 0;
+        g->cover = NULL;
+    }
+    else
+    {
+        g->w = r - l + 1;
+        g->h = b - t + 1;
+        g->dx = x0 + l;
+        g->dy = ascent - 1 - top + t;
+        g->cover = malloc(g->w * g->h);
+        for (int y = 0; y < g->h; y++)
+            for (int x = 0; x < g->w; x++)
+                g->cover[y * g->w + x] = count[(t + y) * ow + l + x];
+    }
+    free(count);
+}
+
+
+
+/*
+ * Glyphs of a BDF file, returns the number of glyphs or -1
+ */
+static int load_bdf(const char* name, int factor, int* ascent, int* descent)
+{
+    FILE* f = fopen(name, "r");
+    char line[256];
+    int n = 0, bdfAscent = -1, bdfDescent = -1;
+    int code = -1, advance = 0, w = 0, h = 0, xoff = 0, yoff = 0;
+
+    if (f == NULL)
+        return -1;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        if (sscanf(line, "FONT_ASCENT %d", &bdfAscent) == 1 || sscanf(line, "FONT_DESCENT %d", &bdfDescent) == 1)
+            continue;
+        if (!strncmp(line, "STARTCHAR", 9))
+            code = -1, advance = w = h = xoff = yoff = 0;
+        else if (sscanf(line, "ENCODING %d", &code) == 1)
+            continue;
+        else if (sscanf(line, "DWIDTH %d", &advance) == 1)
+            continue;
+        else if (sscanf(line, "BBX %d %d %d %d", &w, &h, &xoff, &yoff) == 4)
+            continue;
+        else if (!strncmp(line, "BITMAP", 6))
+        {
+            uint8_t* ink = calloc(w * h + 1, 1);
+
+            if (bdfAscent < 0 || bdfDescent < 0)
+            {
+                fclose(f);
+                return -1;
+            }
+            *ascent = (bdfAscent + factor - 1) / factor;
+            *descent = (bdfDescent + factor - 1) / factor;
+
+            for (int y = 0; y < h && fgets(line, sizeof(line), f); y++)
+                for (int x = 0; x < w; x++)
+                {
+                    char hex[2] = { line[x >> 2], 0 };
+                    ink[y * w + x] = (strtol(hex, NULL, 16) >> (3 - (x & 3))) & 1;
+                }
+            if (code >= 0 && n < MAX_GLYPHS)
+            {
+                glyphs[n].code = code;
+                glyphs[n].advance = (advance + factor / 2) / factor;
+                reduce_glyph(&glyphs[n], ink, w, h, xoff, yoff, factor, *ascent);
+                n++;
+            }
+            free(ink);
+        }
+    }
+    fclose(f);
+    return n;
+}
+
+
+
+static int load_kerning(const char* name)
+{
+    FILE* f = fopen(name, "r");
+    char line[256], left[16], right[16];
+    int n = 0, dx;
+
+    if (f == NULL)
+        return -1;
+    while (fgets(line, sizeof(line), f) && n < MAX_KERNS)
+    {
+        if (line[0] == '#' || sscanf(line, "%15s %15s %d", left, right, &dx) != 3)
+            continue;
+        if (parse_char(left, &kerns[n].left) != 0 || parse_char(right, &kerns[n].right) != 0 ||
+            kerns[n].left > 0xFFFF || kerns[n].right > 0xFFFF)
+        {
+            fprintf(stderr, "hub75font: bad kerning pair '%s %s'\n", left, right);
+            continue;
+        }
+        kerns[n++].dx = dx;
+    }
+    fclose(f);
+    return n;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    int factor = 1, ascent = 0, descent = 0, glyphCount, kernCount = 0;
+    const char* name = "font";
+    const char* outName = NULL;
+    const char* kernName = NULL;
+    const char* inName = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] != '-')
+        {
+            inName = argv[i];
+            break;
+        }
+        if (i + 1 >= argc)
+            usage();
+        else if (!strcmp(argv[i], "-s"))
+            factor = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-k"))
+            kernName = argv[++i];
+        else if (!strcmp(argv[i], "-n"))
+            name = argv[++i];
+        else if (!strcmp(argv[i], "-o"))
+            outName = argv[++i];
+        else
+            usage();
+    }
+    if (outName == NULL || inName == NULL || factor < 1 || factor > 8)
+        usage();
+
+    int bpp = (factor > 1) ? 4 : 1;
+
+    if ((glyphCount = load_bdf(inName, factor, &ascent, &descent)) <= 0)
+    {
+        fprintf(stderr, "hub75font: cannot read '%s' (BDF font expected)\n", inName);
+        return 1;
+    }
+    if (kernName != NULL && (kernCount = load_kerning(kernName)) < 0)
+    {
+        fprintf(stderr, "hub75font: cannot read '%s'\n", kernName);
+        return 1;
+    }
+    qsort(glyphs, glyphCount, sizeof(glyph_t), cmp_glyph);
+    qsort(kerns, kernCount, sizeof(kern_t), cmp_kern);
+
+    FILE* f = fopen(outName, "w");
+    if (f == NULL)
+    {
+        fprintf(stderr, "hub75font: cannot write '%s'\n", outName);
+        return 1;
+    }
+
+    const char* base = strrchr(inName, '/') ? strrchr(inName, '/') + 1 : inName;
+    size_t offset = 0;
+
+    fprintf(f, "// Generated by hub75font from %s: %d glyphs, %d bpp, height %d, %d kerning pair(s). Do not edit.\n",
+        base, glyphCount, bpp, ascent + descent, kernCount);
+    char guard[64];         // include guard in the style of include/: NAME__H_
+    int n = 0;
+    for (const char* c = name; *c && n < (int)sizeof(guard) - 5; c++)
+        guard[n++] = isalnum((unsigned char)*c) ? toupper((unsigned char)*c) : '_';
+    strcpy(&guard[n], "__H_");
+    fprintf(f, "#ifndef %s\n#define %s\n\n#include \"LEDfont.h\"\n\n", guard, guard);
+
+    fprintf(f, "static const uint8_t %s_bitmaps[] = {\n", name);
+    for (int i = 0; i < glyphCount; i++)
+    {
+        glyph_t* g = &glyphs[i];
+        int lineBytes = (g->w * bpp + 7) / 8;
+
+        if (g->w == 0)
+            continue;
+        fprintf(f, "\t");
+        for (int y = 0, first = 1; y < g->h; y++)
+            for (int b = 0; b < lineBytes; b++)
+            {
+                int v = 0;
+
+                for (int x = b * 8 / bpp; x < (b + 1) * 8 / bpp && x < g->w; x++)
+                {
+                    int level = g->cover[y * g->w + x];
+
+                    if (bpp == 1)
+                        v |= (level ? 0x80 : 0) >> (x & 7);
+                    else
+                        v |= level << ((x & 1) * 4);
+                }
+                fprintf(f, "%s0x%02x,", first ? "" : " ", v);
+                first = 0;
+            }
+        fprintf(f, "    // U+%04X\n", g->code);
+    }
+    fprintf(f, "};\n\n");
+
+    fprintf(f, "static const ledfontGlyph_t %s_glyphs[] = {\n", name);
+    for (int i = 0; i < glyphCount; i++)
+    {
+        glyph_t* g = &glyphs[i];
+
+        if (offset > 0xFFFF)
+        {
+            fprintf(stderr, "hub75font: more than 64 KB of glyph bitmaps\n");
+            return 1;
+        }
+        fprintf(f, "\t{ 0x%04x, %5zu, %2d, %2d, %2d, %2d, %2d },\n", g->code, g->w ? offset : 0,
+            g->w, g->h, g->dx, g->dy, g->advance);
+        offset += (size_t)g->h * ((g->w * bpp + 7) / 8);
+    }
+    fprintf(f, "};\n\n");
+
+    if (kernCount > 0)
+    {
+        fprintf(f, "static const ledfontKern_t %s_kerning[] = {\n", name);
+        for (int i = 0; i < kernCount; i++)
+            fprintf(f, "\t{ 0x%04x, 0x%04x, %d },\n", kerns[i].left, kerns[i].right, kerns[i].dx);
+        fprintf(f, "};\n\n");
+    }
+
+    fprintf(f, "static const ledfont_t %s = {\n", name);
+    fprintf(f, "\t%d, %d, %d, %d, %d,\n", bpp, ascent + descent, ascent, glyphCount, kernCount);
+    fprintf(f, "\t%s_glyphs, %s%s, %s_bitmaps\n};\n", name, kernCount ? name : "NULL", kernCount ? "_kerning" : "", name);
+    fprintf(f, "\n#endif\n");
+    fclose(f);
+
+    fprintf(stderr, "hub75font: %d glyphs, %zu bytes of bitmaps, %d kerning pair(s)\n", glyphCount, offset, kernCount);
+    return 0;
+}